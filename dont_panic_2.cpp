@@ -1,52 +1,199 @@
 #include <iostream>
 #include <vector>
-#include <list>
-#include <map>
-#include <cfloat>
-#include <set>
 #include <algorithm>
+#include <cstdint>
 
 using namespace std;
 
-typedef pair<int, int> Pair;
+//Rounds lost when the leading clone is spent on a blocker or an elevator
+const int BLOCK_TIME = 4;
+const int UNREACHABLE = UINT16_MAX;
+//Plan with Graph::biStar instead of Graph::aStar
+const bool BIDIRECTIONAL = false;
 
 enum Dir {
     left, right
 };
 
-struct Cell {
-    int parent = -1;
-    double  g = FLT_MAX;
-    bool fromElevator = false;
-    bool placeElevator = false;
-    Dir direction = Dir::right;
+enum class Action {
+    wait, block, elevator
+};
+
+//How a clone has to reach a state for the moves planned after it: blocking needs the clones behind to walk
+//into the cell, building an elevator needs them to walk or climb into it. Forward states are tagged with how
+//the clone did reach them: walk, walkOrClimb after a climb, any after a turn.
+enum class Arrival {
+    any, walk, walkOrClimb
+};
+
+//Search storage over the layered states of a level: parent state and integer cost per state.
+//Slots stamped with the current generation were reached by the current search, generation + 1 once closed,
+//anything older reads as unseen. A new search only bumps the generation, the storage is not cleared.
+class SearchWorkspace {
+    vector<uint32_t> parents;
+    vector<uint16_t> costs;
+    vector<uint16_t> stamps;
+    uint16_t generation = 0;
+
+public:
+    static constexpr uint16_t UNSEEN = UINT16_MAX;
+
+    void reset(int totalSize) {
+        if ((int) stamps.size() != totalSize || generation >= UINT16_MAX - 2) {
+            parents.resize(totalSize);
+            costs.resize(totalSize);
+            stamps.assign(totalSize, 0);
+            generation = 0;
+        }
+        generation += 2;
+    }
+
+    uint16_t getCost(int i) const {
+        return stamps[i] >= generation ? costs[i] : UNSEEN;
+    }
+
+    int getParent(int i) const {
+        return parents[i];
+    }
+
+    void update(int i, int cost, int parent) {
+        costs[i] = cost;
+        parents[i] = parent;
+        stamps[i] = generation;
+    }
+
+    bool isClosed(int i) const {
+        return stamps[i] == generation + 1;
+    }
+
+    void close(int i) {
+        stamps[i] = generation + 1;
+    }
+};
 
-    bool canPlaceElevator(int maxElevator) {
-        return fromElevator;
+//Open list for small integer costs: one bucket of states per cost, popped in increasing cost order.
+//Costs pushed must not be lower than the last popped one. Decrease-key pushes the state again,
+//the stale copy is skipped once the state is closed.
+class BucketQueue {
+    vector<vector<uint32_t>> buckets;
+    int current = 0;
+    int count = 0;
+
+public:
+    void clear() {
+        for (auto &bucket: buckets) {
+            bucket.clear();
+        }
+        current = 0;
+        count = 0;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    int size() const {
+        return count;
+    }
+
+    //Lowest cost queued, stale entries included
+    int top() {
+        while (buckets[current].empty()) {
+            current++;
+        }
+        return current;
     }
 
+    void push(int cost, int state) {
+        if (cost >= (int) buckets.size()) {
+            buckets.resize(cost + 1);
+        }
+        buckets[cost].push_back(state);
+        count++;
+    }
+
+    //Returns the state with the lowest cost, the most recently pushed first among equals
+    int pop() {
+        while (buckets[current].empty()) {
+            current++;
+        }
+        int state = buckets[current].back();
+        buckets[current].pop_back();
+        count--;
+        return state;
+    }
 };
 
+//States are laid out by blockers placed, then elevators built, then direction (left-facing cells mirrored
+//so that walking is always +1), then floor and position.
 class Level {
-    int nbFloors, width,size, addElevators;
-    vector<int> elevators;
+    int nbFloors, width,size, addElevators, maxBlocks;
+    //Per floor elevator bitmap and nearest elevator at or left/right of each cell, -1 when there is none
+    vector<bool> elevators;
+    vector<int> nextLeft;
+    vector<int> nextRight;
+    //Clones left as blockers during the game, the clones behind cannot walk through them
+    vector<bool> blockers;
 public:
-    Level(int nbFloors, int width,int addElevators) : nbFloors(nbFloors), width(width),size(nbFloors * width),addElevators(addElevators) {}
+    Level(int nbFloors, int width,int addElevators, int maxBlocks) : nbFloors(nbFloors), width(width),size(nbFloors * width),addElevators(addElevators),
+                                                     maxBlocks(maxBlocks), elevators(size, false), nextLeft(size, -1), nextRight(size, -1),
+                                                     blockers(size, false) {}
 
     int getFloor(int i) const {
         return (i%size) / width;
     }
 
-    bool hasUpCell(int i) const {
+    //Number of elevators built to reach the state
+    int getBuilt(int i) const {
+        return i / (size * 2) % (addElevators + 1);
+    }
+
+    //Number of clones left as blockers to reach the state
+    int getBlocks(int i) const {
+        return i / (size * 2 * (addElevators + 1));
+    }
 
-        return find(elevators.begin(), elevators.end(), toBase(i)) != elevators.end();
+    //Same floor, position and direction with the given blockers and elevators used
+    int withLayer(int i, int blocks, int built) const {
+        return i % (size * 2) + size * 2 * (built + (addElevators + 1) * blocks);
+    }
+
+    int getMaxBlocks() const {
+        return maxBlocks;
+    }
+
+    int getAddElevators() const {
+        return addElevators;
+    }
+
+    //How the clone in state i came from parent
+    Arrival arrival(int parent, int i) const {
+        if (parent + 1 == i && getFloor(parent) == getFloor(i)) {
+            return Arrival::walk;
+        }
+        return getFloor(parent) < getFloor(i) ? Arrival::walkOrClimb : Arrival::any;
+    }
+
+    //A clone that arrived as arrived can make the moves that need needed
+    static bool allows(Arrival arrived, Arrival needed) {
+        return needed == Arrival::any || arrived == Arrival::walk || arrived == needed;
+    }
+
+    //State of a clone in the first layer
+    int getState(int floor, int pos, Dir dir) const {
+        int base = floor * width + pos;
+        return dir == Dir::right ? base : oppositeCell(base);
+    }
+
+    bool hasUpCell(int i) const {
+        return elevators[toBase(i)];
     }
 
     bool hasNextCell(int i) const {
         if (hasUpCell(i)) {
             return false;
         }
-        return (i % width) + 1 < width;
+        return (i % width) + 1 < width && !blockers[toBase(i + 1)];
     }
 
     int oppositeCell(int i) const{
@@ -73,12 +220,40 @@ public:
 
     bool hasOppositeCell(int i ) const{
         int opp = oppositeCell(i);
-        return hasNextCell(opp);
+        return getBlocks(i) < maxBlocks && hasNextCell(opp);
+    }
+
+    //The clone blocks and the next one turns around one cell back
+    int blockCell(int i) const {
+        return oppositeCell(i) + 1 + size * 2 * (addElevators + 1);
+    }
+
+    //The clone builds an elevator and the next one goes up
+    int buildCell(int i) const {
+        return i + size * 2 + width;
     }
 
     void addElevator(int elevatorFloor, int elevatorPosition) {
         int e = elevatorFloor * width + elevatorPosition;
-        elevators.push_back(e);
+        elevators[e] = true;
+
+        int first = elevatorFloor * width;
+        for (int pos = elevatorPosition; pos < width && (pos == elevatorPosition || !elevators[first + pos]); pos++) {
+            nextLeft[first + pos] = elevatorPosition;
+        }
+        for (int pos = elevatorPosition; pos >= 0 && (pos == elevatorPosition || !elevators[first + pos]); pos--) {
+            nextRight[first + pos] = elevatorPosition;
+        }
+    }
+
+    //An elevator built during the game, one less left to build
+    void buildElevator(int floor, int pos) {
+        addElevator(floor, pos);
+        addElevators--;
+    }
+
+    void addBlocker(int floor, int pos) {
+        blockers[floor * width + pos] = true;
     }
 
     int getSize() const {
@@ -94,186 +269,397 @@ public:
         return src == dest;
     }
 
-    int dist(int src, int dest) {
-        int s_floor = src / width;
-        int d_floor = dest / width;
+    Dir getDirection(int i) const {
+        return i % (size * 2) < size ? Dir::right : Dir::left;
+    }
 
-        int s_pos = src % width;
-        int d_pos = dest % width;
+    static bool isBehind(int pos, int target, Dir dir) {
+        return dir == Dir::right ? target < pos : target > pos;
+    }
 
-        return abs(s_floor - d_floor) * width + abs(s_pos - d_pos);
+    //Position target of the floor is behind the clone in state i, it has to turn at least once to get there
+    bool isBehind(int i, int target) const {
+        return isBehind(toBase(i) % width, target, getDirection(i));
+    }
 
+    //Rounds to walk from pos to target facing dir, counting the turn when target is behind
+    static int walkCost(int pos, int target, Dir dir) {
+        return abs(target - pos) + (isBehind(pos, target, dir) ? BLOCK_TIME - 1 : 0);
     }
 
+    //Cheapest walk to an existing elevator of the floor, UNREACHABLE when there is none
+    int nearestElevator(int floor, int pos, Dir dir) const {
+        int left = nextLeft[floor * width + pos];
+        int right = nextRight[floor * width + pos];
+        int best = UNREACHABLE;
+        if (left >= 0) {
+            best = walkCost(pos, left, dir);
+        }
+        if (right >= 0) {
+            best = min(best, walkCost(pos, right, dir));
+        }
+        return best;
+    }
 
-    bool hasAddElevator(int i ){
-        int t = (i / (size * 2));
-        return (i / (size * 2)) < addElevators;
+    //Admissible estimate of the rounds from state i to the exit dest: one round per floor and per cell,
+    //a turn when the exit is behind, and once no elevator can be built, the walk to an existing one.
+    int dist(int i, int dest) const {
+        int base = toBase(i);
+        int floor = base / width;
+        int pos = base % width;
+        int floorsLeft = dest / width - floor;
+        if (floorsLeft < 0) {
+            return UNREACHABLE;
+        }
+        Dir dir = getDirection(i);
+        int estimate = floorsLeft + walkCost(pos, dest % width, dir);
+        if (floorsLeft > 0 && getBuilt(i) >= addElevators) {
+            int elevator = nearestElevator(floor, pos, dir);
+            if (elevator == UNREACHABLE) {
+                return UNREACHABLE;
+            }
+            estimate = max(estimate, floorsLeft + elevator);
+        }
+        return estimate;
+    }
+
+    bool hasAddElevator(int i ) const {
+        return getBuilt(i) < addElevators && getFloor(i) + 1 < nbFloors && !hasUpCell(i);
     }
 
     int totalSize()const{
-        return size * 2 * (addElevators +1);
+        return size * 2 * (addElevators +1) * (maxBlocks + 1);
     }
 
 };
 
 class Graph {
-    list<int> *adj;
     int size;
 
-    const int BLOCK_TIME = 4;
-public:
-
-    explicit Graph(int size) : size(size) {
-        adj = new list<int>[size];
-    }
-
-    void addEdge(int u, int v) {
-        adj[u].push_back(v);
+    BucketQueue openList;
+    BucketQueue backList;
+    long expanded = 0;
+
+    //Calls relax(node, d, cost) for every move of the clone in the forward node, nodes are states tagged with
+    //their Arrival: Arrival * totalSize + state
+    template<typename Relax>
+    void expand(int node, Level *level, Relax relax) {
+        int total = level->totalSize();
+        int i = node % total;
+        Arrival arrived = Arrival(node / total);
+        //Next Cell
+        if (level->hasNextCell(i)) {
+            relax(node, int(Arrival::walk) * total + i + 1, 1);
+        }
+        //The clones behind only turn at a blocker when walking into it, and only keep their direction
+        //up a new elevator when they did not just turn around
+        //Opposite Cell
+        if (Level::allows(arrived, Arrival::walk) && level->hasOppositeCell(i)) {
+            relax(node, int(Arrival::any) * total + level->blockCell(i), BLOCK_TIME);
+        }
+        //Elevator
+        if (level->hasUpCell(i)) {
+            relax(node, int(Arrival::walkOrClimb) * total + i + level->getWidth(), 1);
+        }
+        //Build elevator
+        if (Level::allows(arrived, Arrival::walkOrClimb) && level->hasAddElevator(i)) {
+            relax(node, int(Arrival::walkOrClimb) * total + level->buildCell(i), BLOCK_TIME);
+        }
     }
 
-    void removeEdge(int u, int v) {
-        adj[u].remove(v);
-    }
+public:
 
-    const list<int> getAdj(int index) const {
-        return adj[index];
-    }
+    explicit Graph(int size) : size(size) {}
 
     int getSize() const {
         return size;
     }
 
-    void aStar(int src, int dest, Level *level, Cell *cells) {
-        bool *closedList = new bool[level->totalSize()];
-        for (int i = 0; i < level->getSize(); i++) {
-            closedList[i] = false;
-        }
+    //A* over the layered states ordered by cost plus Level::dist. States that cannot reach the exit
+    //within rounds, or with the clones left, are pruned.
+    //Returns the exit node reached, -1 when the exit is unreachable. The path is read back through the parents,
+    //space holds three times the states, one per Arrival (see expand).
+    //srcParent is the state the clone came from, src itself when unknown.
+    int aStar(int src, int srcParent, int dest, Level *level, SearchWorkspace &space, int rounds = UNREACHABLE - 1,
+              int clones = UNREACHABLE) {
+        int total = level->totalSize();
+        int start = int(level->arrival(srcParent, src)) * total + src;
+        space.reset(total * 3);
+        space.update(start, 0, start);
+
+        openList.clear();
+        openList.push(level->dist(src, dest), start);
+        expanded = 0;
+
+        auto relax = [&](int node, int d, int cost) {
+            int gNew = space.getCost(node) + cost;
+            if (space.isClosed(d) || space.getCost(d) <= gNew) {
+                return;
+            }
+            int i = d % total;
+            int f = gNew + level->dist(i, dest);
+            //Every blocker, elevator built and the turn still needed cost a clone, one more has to reach the exit
+            int spent = level->getBlocks(i) + level->getBuilt(i) + (level->isBehind(i, dest % level->getWidth()) ? 1 : 0) + 1;
+            if (f > rounds || spent > clones) {
+                return;
+            }
+            openList.push(f, d);
+            space.update(d, gNew, node);
+        };
 
-        cells[src].g = 0.0;
-        cells[src].parent = src;
-        cells[src].direction = Dir::right;
+        while (!openList.empty()) {
+            int node = openList.pop();
+            if (space.isClosed(node)) {
+                continue;
+            }
+            space.close(node);
+            expanded++;
 
-        set<pair<double, int>> openList;
-        openList.insert(make_pair(0.0, src));
+            if (level->isDest(node % total, dest)) {
+                return node;
+            }
+            expand(node, level, relax);
+        }
+        cerr << "Did not found exit" << endl;
+        return -1;
+    }
 
+    //Bidirectional A*: forward from src like aStar, and backward from the exit over the reversed moves. Backward
+    //layers count the blockers and elevators still to be placed before the exit, so the exit is a single layer and
+    //a forward and a backward state meet on the same cell and direction when their layers fit the budgets together.
+    //Backward states are tagged with the Arrival their next move needs, a forward node meets the backward nodes
+    //its own Arrival allows. The joined path is written into space, read back like the one of aStar.
+    int biStar(int src, int srcParent, int dest, Level *level, SearchWorkspace &space, SearchWorkspace &backSpace,
+               int rounds = UNREACHABLE - 1, int clones = UNREACHABLE) {
+        int total = level->totalSize();
+        int width = level->getWidth();
+        int srcBase = level->toBase(src);
+        Dir srcDir = level->getDirection(src);
+        space.reset(total * 3);
+        backSpace.reset(total * 3);
+        openList.clear();
+        backList.clear();
+        expanded = 0;
+
+        //Only joined paths that fit in the rounds left are kept
+        int best = rounds + 1;
+        int meetForward = -1, meetParent = -1, meetBackward = -1, meetNext = -1;
+
+        //Lower bound of the rounds from src, consistent over the reversed moves: a turn when the direction differs,
+        //two when the state is behind src in the same direction
+        auto backDist = [&](int i) {
+            int base = level->toBase(i);
+            int floors = base / width - srcBase / width;
+            if (floors < 0) {
+                return UNREACHABLE;
+            }
+            Dir dir = level->getDirection(i);
+            int turns = dir != srcDir ? 1 : Level::isBehind(srcBase % width, base % width, dir) ? 2 : 0;
+            return floors + abs(base % width - srcBase % width) + turns * (BLOCK_TIME - 1);
+        };
+
+        //Parents are recorded as they are now, the open state of either side may get a cheaper one later
+        auto meet = [&](int forward, int backward) {
+            int cost = space.getCost(forward) + backSpace.getCost(backward);
+            if (cost < best) {
+                best = cost;
+                meetForward = forward;
+                meetParent = space.getParent(forward);
+                meetBackward = backward;
+                meetNext = backSpace.getParent(backward);
+            }
+        };
+
+        //Pairs the node of one side with the nodes of the other side on its cell that fit the budgets
+        auto meetAll = [&](int forward, int backward) {
+            int i = forward >= 0 ? forward % total : backward % total;
+            int blocks = level->getBlocks(i);
+            int built = level->getBuilt(i);
+            for (int b = 0; blocks + b <= level->getMaxBlocks(); b++) {
+                for (int k = 0; built + k <= level->getAddElevators() && blocks + built + b + k + 1 <= clones; k++) {
+                    int other = level->withLayer(i, b, k);
+                    for (int a = 0; a < 3; a++) {
+                        int node = a * total + other;
+                        if (forward >= 0) {
+                            if (backSpace.getCost(node) != SearchWorkspace::UNSEEN &&
+                                Level::allows(Arrival(forward / total), Arrival(a))) {
+                                meet(forward, node);
+                            }
+                        } else if (space.getCost(node) != SearchWorkspace::UNSEEN &&
+                                   Level::allows(Arrival(a), Arrival(backward / total))) {
+                            meet(node, backward);
+                        }
+                    }
+                }
+            }
+        };
 
-        bool foundDest = false;
+        auto relax = [&](int node, int d, int cost) {
+            int gNew = space.getCost(node) + cost;
+            if (space.isClosed(d) || space.getCost(d) <= gNew) {
+                return;
+            }
+            int i = d % total;
+            int f = gNew + level->dist(i, dest);
+            int spent = level->getBlocks(i) + level->getBuilt(i) + (level->isBehind(i, dest % width) ? 1 : 0) + 1;
+            if (f > rounds || f >= best || spent > clones) {
+                return;
+            }
+            openList.push(f, d);
+            space.update(d, gNew, node);
+            meetAll(d, -1);
+        };
+
+        //node is reached backward from next, the clone walks from node to next
+        auto relaxBack = [&](int next, int node, int cost) {
+            int gNew = backSpace.getCost(next) + cost;
+            int i = node % total;
+            if (backSpace.isClosed(node) || backSpace.getCost(node) <= gNew || level->isDest(i, dest)) {
+                return;
+            }
+            int f = gNew + backDist(i);
+            if (f > rounds || f >= best || level->getBlocks(i) + level->getBuilt(i) + 1 > clones) {
+                return;
+            }
+            backList.push(f, node);
+            backSpace.update(node, gNew, next);
+            meetAll(-1, node);
+        };
+
+        int start = int(level->arrival(srcParent, src)) * total + src;
+        space.update(start, 0, start);
+        openList.push(level->dist(src, dest), start);
+        for (int exit: {dest, level->oppositeCell(dest)}) {
+            backSpace.update(exit, 0, exit);
+            backList.push(backDist(exit), exit);
+            meetAll(-1, exit);
+        }
 
-        while (!openList.empty()) {
-            pair<double, int> p = *openList.begin();
-            openList.erase(openList.begin());
-            int i = p.second;
+        while (!openList.empty() && !backList.empty() && best > max(openList.top(), backList.top())) {
+            if (openList.size() <= backList.size()) {
+                int node = openList.pop();
+                if (space.isClosed(node)) {
+                    continue;
+                }
+                space.close(node);
+                expanded++;
+                if (!level->isDest(node % total, dest)) {
+                    expand(node, level, relax);
+                }
+                continue;
+            }
 
-            closedList[i] = true;
+            int node = backList.pop();
+            if (backSpace.isClosed(node)) {
+                continue;
+            }
+            backSpace.close(node);
+            expanded++;
+            int i = node % total;
+            Arrival arrival = Arrival(node / total);
+            int blocks = level->getBlocks(i);
+            int built = level->getBuilt(i);
+
+            //Walked in
+            if (i % width > 0 && level->hasNextCell(i - 1)) {
+                relaxBack(node, i - 1, 1);
+            }
+            if (arrival == Arrival::walk || level->getFloor(i) == 0) {
+                continue;
+            }
+            //Rode an elevator up
+            if (level->hasUpCell(i - width)) {
+                relaxBack(node, i - width, 1);
+            }
+            //Built the elevator below
+            if (built < level->getAddElevators() && level->hasAddElevator(i - width)) {
+                relaxBack(node, int(Arrival::walkOrClimb) * total + level->withLayer(i - width, blocks, built + 1),
+                          BLOCK_TIME);
+            }
+            //Turned at a blocker, placed one cell further
+            if (arrival == Arrival::any && i % width > 0 && blocks < level->getMaxBlocks()) {
+                int turn = level->oppositeCell(i - 1);
+                if (level->hasOppositeCell(turn)) {
+                    relaxBack(node, int(Arrival::walk) * total + level->withLayer(turn, blocks + 1, built), BLOCK_TIME);
+                }
+            }
+        }
 
-            double gNew;
+        if (best > rounds) {
+            cerr << "Did not found exit" << endl;
+            return -1;
+        }
 
-            //Next Cell
-            if (level->hasNextCell(i)) {
-                int d = i + 1;
-                if (level->isDest(d,dest)) {
-                    cells[level->toBase(d)].parent = i;
-                    cells[level->toBase(d)].g = cells[i].g;
-                    cells[level->toBase(d)].placeElevator = false;
-                    foundDest = true;
-                    return;
-                } else if (!closedList[d]) {
-                    gNew = cells[i].g + 1 ;
+        //Forward nodes along the backward half, with the layers used so far
+        space.update(meetForward, space.getCost(meetForward), meetParent);
+        int blocks = level->getBlocks(meetForward % total) + level->getBlocks(meetBackward % total);
+        int built = level->getBuilt(meetForward % total) + level->getBuilt(meetBackward % total);
+        int state = meetForward % total;
+        int forwardNode = meetForward;
+        for (int node = meetBackward, next = meetNext; next != node; node = next, next = backSpace.getParent(node)) {
+            int i = next % total;
+            int forward = level->withLayer(i, blocks - level->getBlocks(i), built - level->getBuilt(i));
+            int tagged = int(level->arrival(state, forward)) * total + forward;
+            space.update(tagged, best - backSpace.getCost(next), forwardNode);
+            state = forward;
+            forwardNode = tagged;
+        }
+        return forwardNode;
+    }
 
-                    if (cells[d].g == FLT_MAX || cells[d].g > gNew) {
+    long getExpanded() const {
+        return expanded;
+    }
 
-                        openList.insert(make_pair(gNew, d));
+};
 
-                        cells[d].g = gNew;
+//Commands for the leading clone read off a planned path, looked up by its floor, position and direction
+class Schedule {
+    int width = 0;
+    vector<Action> actions;
+    vector<bool> planned;
 
-                        cells[d].parent = i;
-                        cells[d].direction = Dir::right;
-                        cells[d].placeElevator = false;
-                    }
-                }
-            }
-            //Opposite Cell
-            if (level->hasOppositeCell(i)) {
-                int d = level->oppositeCell(i) + 1;
-                if (level->isDest(d,dest)) {
-                    cells[level->toBase(d)].parent = i;
-                    cells[level->toBase(d)].g = cells[i].g;
-                    cells[level->toBase(d)].placeElevator = false;
-                    foundDest = true;
-                    return;
-                } else if (!closedList[d]) {
-                    gNew = cells[i].g +BLOCK_TIME;
-
-                    if (cells[d].g == FLT_MAX || cells[d].g > gNew) {
-
-                        openList.insert(make_pair(gNew, d));
-
-                        cells[d].g = gNew;
-
-                        cells[d].parent = i;
-                        cells[d].direction = Dir::left;
-                        cells[d].placeElevator = false;
-                    }
-                }
-            }
-            //Elevator
-            if (level->hasUpCell(i)) {
-                int d = i + level->getWidth();
-                if (level->isDest(d,dest)) {
-                    cells[level->toBase(d)].parent = i;
-                    cells[level->toBase(d)].g = cells[i].g;
-                    cells[level->toBase(d)].placeElevator = false;
-                    foundDest = true;
-                    return;
-                } else if (!closedList[d]) {
-                    gNew = cells[i].g + 1;
-
-                    if (cells[d].g == FLT_MAX || cells[d].g > gNew) {
-
-                        openList.insert(make_pair(gNew, d));
-
-                        cells[d].g = gNew;
-                        cells[d].parent = i;
-                        cells[d].direction = cells[i].direction;
-                        cells[d].placeElevator = false;
-                        cells[d].fromElevator = true;
-                    }
-                }
+    int key(int floor, int pos, Dir dir) const {
+        return (floor * width + pos) * 2 + (dir == Dir::right ? 1 : 0);
+    }
+
+public:
+    //Blockers and elevators along the path from src to the exit state, none when exit is -1
+    void build(const Level &level, const SearchWorkspace &space, int src, int exit) {
+        width = level.getWidth();
+        actions.assign(level.getSize() * 2, Action::wait);
+        planned.assign(level.getSize() * 2, false);
+        int total = level.totalSize();
+        for (int node = exit; node >= 0; node = space.getParent(node)) {
+            int cursor = node % total;
+            int base = level.toBase(cursor);
+            planned[key(base / width, base % width, level.getDirection(cursor))] = true;
+            if (cursor == src) {
+                break;
             }
-            //Build elevator
-            if (cells[i].fromElevator && level->hasAddElevator(i) ) {
-                int d = i + level->getSize() * 2 ;
-                d += level->getWidth();
-                if (level->isDest(d,dest)) {
-                    cells[level->toBase(d)].parent = i;
-                    cells[level->toBase(d)].placeElevator = true;
-                    cells[level->toBase(d)].g = cells[i].g;
-                    foundDest = true;
-                    return;
-                } else if (!closedList[d]) {
-                    gNew = cells[i].g + BLOCK_TIME;
-
-                    if (cells[d].g == FLT_MAX || cells[d].g > gNew) {
-                        int ii= level->toBase(i);
-                        int dd = level->toBase(d);
-                        openList.insert(make_pair(gNew, d));
-
-                        cells[d].g = gNew;
-
-                        cells[d].parent = i;
-                        cells[d].direction = cells[i].direction;
-                        cells[d].placeElevator = true;
-                        cells[d].fromElevator = true;
-                    }
-                }
+            int parent = space.getParent(node) % total;
+            base = level.toBase(parent);
+            int k = key(base / width, base % width, level.getDirection(parent));
+            if (level.getBlocks(parent) < level.getBlocks(cursor)) {
+                actions[k] = Action::block;
+            } else if (level.getBuilt(parent) < level.getBuilt(cursor)) {
+                actions[k] = Action::elevator;
             }
         }
-        if (!foundDest) {
-            cout << "Did not found exit" << endl;
-        }
     }
 
+    //The leading clone is where the plan expects it
+    bool isPlanned(int floor, int pos, Dir dir) const {
+        return !planned.empty() && planned[key(floor, pos, dir)];
+    }
+
+    //Each action is played once, the clones behind follow the blockers and elevators already in place
+    Action next(int floor, int pos, Dir dir) {
+        int k = key(floor, pos, dir);
+        Action action = actions[k];
+        actions[k] = Action::wait;
+        return action;
+    }
 };
 
 int main() {
@@ -289,8 +675,8 @@ int main() {
         >> nbElevators;
     cin.ignore();
 
-    Level level = Level(nbFloors, width,nbAdditionalElevators);
-    cout << level.totalSize();
+    //Every clone but the one reaching the exit can be left as a blocker
+    Level level = Level(nbFloors, width, nbAdditionalElevators, nbTotalClones - 1);
     for (int i = 0; i < nbElevators; i++) {
         int elevatorFloor; // floor on which this elevator is found
         int elevatorPos; // position of the elevator on its floor
@@ -300,42 +686,53 @@ int main() {
 
     }
 
-    int cloneIndex = 6;
-
     Graph graph = Graph(level.getSize());
-
-    Cell *cells = new Cell[level.totalSize()];
+    SearchWorkspace space;
+    SearchWorkspace backSpace;
+    Schedule schedule;
+    int spent = 0;
+    int lastState = -1;
 
     int exitIndex = exitFloor * width + exitPos;
-    graph.aStar(cloneIndex, exitIndex, &level, cells);
-
-    vector<int> path;
-    vector<int> addElevators;
-    bool nextElevator = false;
 
-    int cursor = exitIndex;
-    path.push_back(exitIndex);
-
-    while (cursor != cloneIndex){
-        cursor = cells[cursor].parent;
-        if (nextElevator){
-            nextElevator = false;
-            addElevators.push_back(level.toBase(cursor));
-        }
-        if (cells[cursor].placeElevator){
-            nextElevator = true;
+    // game loop
+    for (int round = 0;; round++) {
+        int cloneFloor; // floor of the leading clone
+        int clonePos; // position of the leading clone on its floor
+        string direction; // direction of the leading clone: LEFT or RIGHT
+        if (!(cin >> cloneFloor >> clonePos >> direction)) {
+            break;
         }
-        path.push_back(level.toBase(cursor));
-    }
-
-
+        cin.ignore();
 
-    for (auto p : path){
-        cout << p;
-        if (find(addElevators.begin(), addElevators.end(),p) != addElevators.end()){
-            cout << " add elevator";
+        Action action = Action::wait;
+        if (cloneFloor >= 0) {
+            Dir dir = direction == "LEFT" ? Dir::left : Dir::right;
+            int state = level.getState(cloneFloor, clonePos, dir);
+            //Planned from the first clone, then again only when the leading clone leaves the path
+            if (!schedule.isPlanned(cloneFloor, clonePos, dir)) {
+                int parent = lastState >= 0 ? lastState : state;
+                int exit = BIDIRECTIONAL ? graph.biStar(state, parent, exitIndex, &level, space, backSpace,
+                                                        nbRounds - round, nbTotalClones - spent)
+                                         : graph.aStar(state, parent, exitIndex, &level, space,
+                                                       nbRounds - round, nbTotalClones - spent);
+                schedule.build(level, space, state, exit);
+            }
+            action = schedule.next(cloneFloor, clonePos, dir);
+            lastState = state;
+
+            //The leading clone is spent, the next one comes from behind
+            if (action == Action::block) {
+                level.addBlocker(cloneFloor, clonePos);
+            } else if (action == Action::elevator) {
+                level.buildElevator(cloneFloor, clonePos);
+            }
+            if (action != Action::wait) {
+                spent++;
+                lastState = -1;
+            }
         }
-        cout <<endl;
-    }
 
-}
\ No newline at end of file
+        cout << (action == Action::block ? "BLOCK" : action == Action::elevator ? "ELEVATOR" : "WAIT") << endl;
+    }
+}
@@ -1,33 +1,96 @@
-#include <list>
 #include <string>
 #include <vector>
 #include <algorithm>
 #include <iostream>
 #include <chrono>
-#include <map>
 #include <numeric>
+#include <cstdint>
+#include <random>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <cmath>
+#include <cassert>
+#include <unistd.h>
+
+#ifdef BENCHMARK
+#include <fstream>
+#include <map>
+#endif
 
 using namespace std;
 using namespace std::chrono;
 
-int SIM_STEPS = 6;
+//Maximum search depth, the actual depth is bounded by SIM_BUDGET_MS
+int SIM_STEPS = 20;
+int SIM_BUDGET_MS = 40;
+const int CLOCK_CHECK = 1024;
+const int MAX_PACS = 5;
+const int MAX_NEIGHBORS = 4;
+const int NO_PLAN = INT32_MIN / 2;
+const int TT_BITS = 18;
+const int TT_MIN_REMAINING = 2;
+//Score lost when stepping where an enemy is sure to be, and fading of unseen enemies per turn
+const int ENEMY_RISK = 20;
+const float ENEMY_DECAY = 0.9f;
+const int SUPER_PELLET = 10;
+//Monte Carlo planner: node pool size, UCB exploration, iterations between clock reads
+const int MCTS_POOL = 1 << 19;
+const float MCTS_EXPLORATION = 0.7f;
+const int MCTS_CLOCK_CHECK = 16;
+const uint64_t MCTS_SEED = 12345;
+
+//Non-owning view over the neighbors of one cell
+class Neighbors {
+    const int *first;
+    const int *last;
+
+public:
+    Neighbors() : first(nullptr), last(nullptr) {}
+
+    Neighbors(const int *first, const int *last) : first(first), last(last) {}
+
+    const int *begin() const {
+        return first;
+    }
 
+    const int *end() const {
+        return last;
+    }
+
+    int size() const {
+        return last - first;
+    }
+
+    int operator[](int i) const {
+        return first[i];
+    }
+};
+
+//Compressed sparse row graph: neighbors of i are neighbors[offsets[i]..offsets[i+1])
 class Graph {
-    list<int> *adj;
+    vector<int> offsets;
+    vector<int> neighbors;
+    vector<bool> tunnels;
     int size;
 
 public:
 
-    explicit Graph(int size) : size(size) {
-        adj = new list<int>[size];
-    }
+    Graph(vector<int> offsets, vector<int> neighbors, vector<bool> tunnels)
+            : offsets(move(offsets)), neighbors(move(neighbors)), tunnels(move(tunnels)),
+              size(this->offsets.size() - 1) {}
 
-    void addEdge(int u, int v) {
-        adj[u].push_back(v);
+    Neighbors getAdj(int index) const {
+        const int *base = neighbors.data();
+        return Neighbors(base + offsets[index], base + offsets[index + 1]);
     }
 
-    const list<int> getAdj(int index) const {
-        return adj[index];
+    //True when the k-th neighbor of index is reached through a wraparound tunnel
+    bool isTunnel(int index, int k) const {
+        return tunnels[offsets[index] + k];
     }
 
     int getSize() const {
@@ -37,274 +100,1500 @@ public:
 
 };
 
-class Simulation {
-    Graph *graph;
-    int steps;
+//BFS over the cell grid with one bitmask per row (width <= 64), a frontier layer is expanded a whole
+//row per word operation. Cells wrap around on both axes like the map tunnels.
+class DistanceField {
+    int width, height;
+    uint64_t rowMask;
+    vector<uint64_t> open;
+    vector<int> cells;
+    vector<int> positions;
+
+    vector<uint64_t> frontier;
+    vector<uint64_t> reached;
+    vector<uint64_t> next;
+    vector<uint64_t> targets;
+    vector<uint64_t> blocked;
+
+    void setBit(vector<uint64_t> &mask, int index) {
+        int position = positions[index];
+        mask[position / width] |= 1ULL << (position % width);
+    }
 
-    void
-    doStep(vector<int> &myPacs, int total, vector<int> &bestSimulation, int &bestTotal, int *pellets, bool *visited,
-           int step) {
+    //Cells next to the frontier not reached yet, returns false once the frontier is empty
+    bool expand() {
+        bool any = false;
+        for (int y = 0; y < height; y++) {
+            uint64_t f = frontier[y];
+            uint64_t row = (f << 1) | (f >> 1) | (f >> (width - 1)) | ((f & 1) << (width - 1));
+            row |= frontier[(y + height - 1) % height] | frontier[(y + 1) % height];
+            next[y] = row & rowMask & open[y] & ~reached[y];
+            any = any || next[y] != 0;
+        }
+        return any;
+    }
 
+    int firstCell(const vector<uint64_t> &mask) const {
+        for (int y = 0; y < height; y++) {
+            if (mask[y] != 0) {
+                return cells[y * width + __builtin_ctzll(mask[y])];
+            }
+        }
+        return -1;
+    }
 
-        if (step >= steps) {
-            if (total > bestTotal) {
-                bestSimulation = myPacs;
-                bestTotal = total;
+    void start(int source) {
+        fill(frontier.begin(), frontier.end(), 0);
+        fill(reached.begin(), reached.end(), 0);
+        setBit(frontier, source);
+        setBit(reached, source);
+    }
+
+public:
+    //cells maps y * width + x to a cell index (-1 on walls), positions is the inverse
+    DistanceField(int width, int height, const vector<int> &cells, const vector<int> &positions)
+            : width(width), height(height), rowMask(width >= 64 ? ~0ULL : (1ULL << width) - 1),
+              open(height, 0), cells(cells), positions(positions), frontier(height), reached(height),
+              next(height), targets(height, 0), blocked(height, 0) {
+        //A row is one word, a wider map would shift cells off the mask
+        assert(width <= 64);
+        for (int i = 0; i < (int) positions.size(); i++) {
+            setBit(open, i);
+        }
+    }
+
+    int getSize() const {
+        return positions.size();
+    }
+
+    //Cells holding a pellet are the targets of nearestTarget
+    void setTargets(const int *pellets) {
+        fill(targets.begin(), targets.end(), 0);
+        for (int i = 0; i < getSize(); i++) {
+            if (pellets[i] > 0) {
+                setBit(targets, i);
             }
-        } else {
+        }
+    }
 
-            //Get next moves by pac
-            vector<vector<int>> pacsNext;
-            getAdj(myPacs, pacsNext, visited);
-
-            //Get all possible combinations for that step
-            vector<vector<int>> simulations;
-            combination(pacsNext, simulations);
-
-            //For each simulation
-            for (auto simulation: simulations) {
-
-                //Check for collision
-                if (!hasCollision(myPacs, simulation)) {
-                    vector<int> pacPellets;
-                    for (int i = 0; i < simulation.size(); i++) {
-                        //Add pellets to total and remove pellet from vector
-                        pacPellets.push_back(pellets[simulation[i]]);
-                        pellets[simulation[i]] = 0;
-                        //update visited
-                        visited[simulation[i] + i * graph->getSize()] = true;
-                    }
-                    //do sim
+    //Cells the search cannot go through, a target on them can still be reached
+    void setBlocked(const vector<int> &indexes) {
+        fill(blocked.begin(), blocked.end(), 0);
+        for (int index: indexes) {
+            setBit(blocked, index);
+        }
+    }
+
+    //Closest target from source, source itself when none is reachable
+    int nearestTarget(int source) {
+        start(source);
+        while (expand()) {
+            bool hit = false;
+            for (int y = 0; y < height; y++) {
+                reached[y] |= next[y];
+                hit = hit || (next[y] & targets[y]) != 0;
+                frontier[y] = next[y] & ~blocked[y];
+            }
+            if (hit) {
+                for (int y = 0; y < height; y++) {
+                    next[y] &= targets[y];
+                }
+                return firstCell(next);
+            }
+        }
+        return source;
+    }
 
+    //Distance from the closest source for every cell, -1 when unreachable
+    void multiSource(const vector<int> &sources, vector<int> &dist) {
+        dist.assign(getSize(), -1);
+        fill(frontier.begin(), frontier.end(), 0);
+        fill(reached.begin(), reached.end(), 0);
+        for (int source: sources) {
+            setBit(frontier, source);
+            setBit(reached, source);
+            dist[source] = 0;
+        }
 
-                    doStep(simulation, accumulate(pacPellets.begin(), pacPellets.end(), total), bestSimulation,
-                           bestTotal,
-                           pellets, visited, step + 1);
-                    for (int i = 0; i < simulation.size(); i++) {
-                        //Remove pellets from total and replace pellet into vector
-                        pellets[simulation[i]] = pacPellets[i];
-                        //replace visited
-                        visited[simulation[i] + i * graph->getSize()] = false;
-                    }
+        for (int d = 1; expand(); d++) {
+            for (int y = 0; y < height; y++) {
+                reached[y] |= next[y];
+                frontier[y] = next[y];
+                for (uint64_t bits = next[y]; bits != 0; bits &= bits - 1) {
+                    dist[cells[y * width + __builtin_ctzll(bits)]] = d;
+                }
+            }
+        }
+    }
+};
 
+//All-pairs shortest path lengths between the open cells, one byte per pair unless a path is longer than 254.
+//Built once per map (a few ms for 400 cells) and shared by the simulations.
+class DistanceMatrix {
+    int size;
+    bool wide = false;
+    vector<uint8_t> bytes;
+    vector<uint16_t> words;
+
+public:
+    static const int UNREACHABLE = 65535;
+
+    explicit DistanceMatrix(DistanceField &field) : size(field.getSize()) {
+        words.assign(size * size, UNREACHABLE);
+        vector<int> dist;
+        int longest = 0;
+        for (int a = 0; a < size; a++) {
+            field.multiSource({a}, dist);
+            for (int b = 0; b < size; b++) {
+                if (dist[b] >= 0) {
+                    words[a * size + b] = dist[b];
+                    longest = max(longest, dist[b]);
                 }
             }
         }
 
+        wide = longest >= 255;
+        if (!wide) {
+            bytes.resize(size * size);
+            for (int i = 0; i < size * size; i++) {
+                bytes[i] = words[i] == UNREACHABLE ? 255 : words[i];
+            }
+            words.clear();
+            words.shrink_to_fit();
+        }
+    }
 
+    int distance(int a, int b) const {
+        if (wide) {
+            return words[a * size + b];
+        }
+        int d = bytes[a * size + b];
+        return d == 255 ? UNREACHABLE : d;
     }
 
-    void getEnemyWeight(vector<int> &enemyPacs, double *cumulativeWeights) {
-        int pathSize = graph->getSize();
+    int getSize() const {
+        return size;
+    }
+};
 
-        double *weights = new double[pathSize * (steps + 1)];
-//        double * cumulativeWeights = new double[pathSize * (steps+1)];
+//Presence of enemy pacs per cell, now and for the next steps. Each turn the belief of the previous
+//turn is walked one step and refreshed with the enemies in sight, then forecast by a random walk along
+//the graph. Neighbors are stored as MAX_NEIGHBORS flat slot arrays padded with an empty cell, so a
+//diffusion step is a branch-free sparse matrix-vector product.
+class EnemyField {
+    int size = 0;
+    int horizon = 0;
+    //Most enemies seen at once, taken as the number of enemies
+    int known = 0;
+    vector<int> slots[MAX_NEIGHBORS];
+    vector<float> weights[MAX_NEIGHBORS];
+    vector<float> belief;
+    vector<float> walk;
+    vector<float> forecast;
+
+    //to[c] = sum over neighbors n of c of from[n] / degree(n)
+    void diffuse(const float *from, float *to) const {
+        const int *s0 = slots[0].data(), *s1 = slots[1].data(), *s2 = slots[2].data(), *s3 = slots[3].data();
+        const float *w0 = weights[0].data(), *w1 = weights[1].data(), *w2 = weights[2].data(), *w3 = weights[3].data();
+        for (int c = 0; c < size; c++) {
+            to[c] = from[s0[c]] * w0[c] + from[s1[c]] * w1[c] + from[s2[c]] * w2[c] + from[s3[c]] * w3[c];
+        }
+        to[size] = 0.0f;
+    }
 
-        for (auto pac : enemyPacs) {
-            weights[pac] = 1.0;
-            cumulativeWeights[pac] = 1.0;
+public:
+    void attach(const Graph &graph, int steps) {
+        if (size == graph.getSize() && horizon == steps) {
+            return;
         }
-        for (int i = 1; i <= steps; i++) {
-            for (int j = 0; j < pathSize; j++) {
-                int prevIndex = (i - 1) * pathSize + j;
-                if (weights[prevIndex] > 0) {
-                    list<int> nexts = graph->getAdj(j);
-                    double weight = 1 / (double) nexts.size();
-                    for (auto next:nexts) {
-                        weights[i * pathSize + next] = weights[prevIndex] * weight;
-                    }
-                }
+        size = graph.getSize();
+        horizon = steps;
+        for (int k = 0; k < MAX_NEIGHBORS; k++) {
+            slots[k].assign(size, size);
+            weights[k].assign(size, 0.0f);
+        }
+        for (int c = 0; c < size; c++) {
+            Neighbors adj = graph.getAdj(c);
+            for (int k = 0; k < min(adj.size(), MAX_NEIGHBORS); k++) {
+                slots[k][c] = adj[k];
+                weights[k][c] = 1.0f / graph.getAdj(adj[k]).size();
+            }
+        }
+        known = 0;
+        belief.assign(size + 1, 0.0f);
+        walk.assign(size + 1, 0.0f);
+        forecast.assign((horizon + 1) * (size + 1), 0.0f);
+    }
+
+    //New turn: enemies unseen this turn fade while they spread, the ones in sight are certain.
+    //The spread mass is capped to the enemies out of sight, so an enemy seen again takes back what it left.
+    void observe(const vector<int> &enemyPacs) {
+        int visible = enemyPacs.size();
+        known = max(known, visible);
+        diffuse(belief.data(), walk.data());
+        for (int c = 0; c < size; c++) {
+            belief[c] = walk[c] * ENEMY_DECAY;
+        }
+        for (int pac: enemyPacs) {
+            belief[pac] = 0.0f;
+        }
+        float unseen = accumulate(belief.begin(), belief.begin() + size, 0.0f);
+        if (unseen > known - visible) {
+            float scale = (known - visible) / unseen;
+            for (int c = 0; c < size; c++) {
+                belief[c] *= scale;
             }
         }
-        for (int i = 0; i < pathSize; i++) {
-            for (int j = 1; j <= steps; j++) {
-                cumulativeWeights[j * pathSize + i] = max(cumulativeWeights[(j - 1) * pathSize + i],
-                                                          weights[j * pathSize + i]);
+        for (int pac: enemyPacs) {
+            belief[pac] = 1.0f;
+        }
+        assert(accumulate(belief.begin(), belief.begin() + size, 0.0f) <= known + 1e-3f);
+
+        //Raw presence at step t is walked from step t - 1, layer t keeps the max of both for crossing paths
+        copy(belief.begin(), belief.end(), forecast.begin());
+        walk = belief;
+        for (int t = 1; t <= horizon; t++) {
+            float *layer = forecast.data() + t * (size + 1);
+            diffuse(walk.data(), layer);
+            for (int c = 0; c < size; c++) {
+                float raw = layer[c];
+                layer[c] = max(raw, walk[c]);
+                walk[c] = raw;
             }
         }
+    }
 
-        delete weights;
+    float presence(int step, int cell) const {
+        return forecast[step * (size + 1) + cell];
     }
+};
 
-    void combination(vector<vector<int>> &source, vector<vector<int>> &results) {
+//One bit per open cell
+class Bitboard {
+    vector<uint64_t> words;
 
-        int n = source.size();
+public:
+    void reset(int size) {
+        words.assign((size + 63) / 64, 0);
+    }
 
-        int *indices = new int[n];
+    bool test(int cell) const {
+        return (words[cell >> 6] >> (cell & 63)) & 1;
+    }
 
-        for (int i = 0; i < n; i++)
-            indices[i] = 0;
+    void set(int cell) {
+        words[cell >> 6] |= 1ULL << (cell & 63);
+    }
 
-        while (1) {
+    void clear(int cell) {
+        words[cell >> 6] &= ~(1ULL << (cell & 63));
+    }
+
+    int count() const {
+        int total = 0;
+        for (uint64_t word: words) {
+            total += __builtin_popcountll(word);
+        }
+        return total;
+    }
 
-            vector<int> single;
-            for (int i = 0; i < n; i++) {
-                vector<int> s = source[i];
-                int j = indices[i];
-                int k = s[j];
-                single.push_back(source[i][indices[i]]);
+    //Every bit set here is set in other
+    bool within(const Bitboard &other) const {
+        if (words.size() != other.words.size()) {
+            return false;
+        }
+        for (int i = 0; i < (int) words.size(); i++) {
+            if ((words[i] & ~other.words[i]) != 0) {
+                return false;
             }
+        }
+        return true;
+    }
 
-            results.emplace_back(single);
+    //Bits set in both boards
+    int countAnd(const Bitboard &other) const {
+        int total = 0;
+        for (int i = 0; i < (int) words.size(); i++) {
+            total += __builtin_popcountll(words[i] & other.words[i]);
+        }
+        return total;
+    }
+};
 
-            int next = n - 1;
-            while (next >= 0 &&
-                   (indices[next] + 1 >= source[next].size()))
-                next--;
+//Pellets left on the map: every pellet is worth 1 except the super pellets, worth SUPER_PELLET.
+//Taking or putting back a pellet is a single AND/ANDN, the value left is counted with popcount on reset.
+class PelletBoard {
+    Bitboard pellets;
+    Bitboard supers;
+    int left = 0;
 
-            if (next < 0)
-                return;
+public:
+    void reset(const int *values, int size) {
+        pellets.reset(size);
+        supers.reset(size);
+        for (int cell = 0; cell < size; cell++) {
+            if (values[cell] > 0) {
+                pellets.set(cell);
+            }
+            if (values[cell] >= SUPER_PELLET) {
+                supers.set(cell);
+            }
+        }
+        left = pellets.count() + (SUPER_PELLET - 1) * pellets.countAnd(supers);
+    }
+
+    int value(int cell) const {
+        return pellets.test(cell) * (1 + (SUPER_PELLET - 1) * supers.test(cell));
+    }
 
-            indices[next]++;
+    //Removes the pellet of cell and returns its value
+    int take(int cell) {
+        int taken = value(cell);
+        pellets.clear(cell);
+        left -= taken;
+        return taken;
+    }
 
-            for (int i = next + 1; i < n; i++)
-                indices[i] = 0;
+    void put(int cell, int taken) {
+        if (taken > 0) {
+            pellets.set(cell);
+            left += taken;
         }
     }
 
-    void getAdj(vector<int> &myPacs, vector<vector<int>> &pacsNext, bool *visited) {
-        for (int i = 0; i < myPacs.size(); i++) {
-            vector<int> pacNext;
-            for (auto next : graph->getAdj(myPacs[i])) {
-                pacNext.push_back(next);
-//                if (!visited[i * graph->getSize() + next]) {
-//                    pacNext.push_back(next);
-//                }
+    //Value of all the pellets left
+    int score() const {
+        return left;
+    }
+
+    //No cell is worth more here than in other
+    bool within(const PelletBoard &other) const {
+        return pellets.within(other.pellets) && supers.within(other.supers);
+    }
+};
+
+//Per-depth scratch buffers of the search, sized once and reused across runs
+class SearchArena {
+    int nbPacs = 0;
+    vector<int> positions;
+    vector<int> eaten;
+
+public:
+    void reset(int steps, int pacs) {
+        nbPacs = pacs;
+        positions.resize((steps + 1) * nbPacs);
+        eaten.resize(steps * nbPacs);
+    }
+
+    //Pac positions after the given step
+    int *at(int step) {
+        return positions.data() + step * nbPacs;
+    }
+
+    //Pellets picked up by each pac during the given step
+    int *eatenAt(int step) {
+        return eaten.data() + step * nbPacs;
+    }
+};
+
+//Random keys for the pac positions and the eaten pellets of a search state
+class ZobristKeys {
+    int size = 0;
+    vector<uint64_t> pacs;
+    vector<uint64_t> pellets;
+    vector<uint64_t> steps;
+
+public:
+    void resize(int cells, int depth) {
+        if (cells == size && depth + 1 == (int) steps.size()) {
+            return;
+        }
+        size = cells;
+        mt19937_64 random(size);
+        pacs.resize(MAX_PACS * size);
+        pellets.resize(size);
+        steps.resize(depth + 1);
+        for (auto &key: pacs) {
+            key = random();
+        }
+        for (auto &key: pellets) {
+            key = random();
+        }
+        for (auto &key: steps) {
+            key = random();
+        }
+    }
+
+    uint64_t pac(int pac, int cell) const {
+        return pacs[pac * size + cell];
+    }
+
+    uint64_t pellet(int cell) const {
+        return pellets[cell];
+    }
+
+    uint64_t step(int step) const {
+        return steps[step];
+    }
+
+    //Hash of the starting positions, nothing eaten yet
+    uint64_t state(const int *positions, int nbPacs) const {
+        uint64_t hash = 0;
+        for (int i = 0; i < nbPacs; i++) {
+            hash ^= pac(i, positions[i]);
+        }
+        return hash;
+    }
+};
+
+//Fixed-size table of upper bounds per (state, remaining steps), a deeper entry replaces a shallower one.
+//Each run is a new generation: entries of older generations stay readable until the next clear, but any
+//entry of the current run replaces them.
+class TranspositionTable {
+    struct Entry {
+        uint64_t key = 0;
+        int upper = 0;
+        short remaining = 0;
+        uint16_t generation = UINT16_MAX;
+    };
+
+    vector<Entry> entries;
+    uint64_t mask;
+    uint16_t generation = 0;
+    uint16_t oldest = 0;
+
+    //Generations wrap around, ages are compared modulo 2^16
+    bool isValid(const Entry &entry) const {
+        return (uint16_t) (generation - entry.generation) <= (uint16_t) (generation - oldest);
+    }
+
+public:
+    explicit TranspositionTable(int bits) : entries(1 << bits), mask((1 << bits) - 1) {}
+
+    //Forgets every entry
+    void clear() {
+        generation++;
+        oldest = generation;
+    }
+
+    //Starts a new run keeping the entries of the previous ones
+    void age() {
+        generation++;
+    }
+
+    bool probe(uint64_t key, int remaining, int &upper) const {
+        const Entry &entry = entries[key & mask];
+        if (isValid(entry) && entry.key == key && entry.remaining == remaining) {
+            upper = entry.upper;
+            return true;
+        }
+        return false;
+    }
+
+    void store(uint64_t key, int remaining, int upper) {
+        Entry &entry = entries[key & mask];
+        if (entry.generation != generation || remaining >= entry.remaining) {
+            entry.key = key;
+            entry.upper = upper;
+            entry.remaining = remaining;
+            entry.generation = generation;
+        }
+    }
+};
+
+//One deque of tasks per worker, an idle worker steals from the back of the others
+class WorkStealingQueue {
+    struct Queue {
+        mutex lock;
+        deque<int> tasks;
+    };
+
+    vector<Queue> queues;
+
+public:
+    explicit WorkStealingQueue(int workers) : queues(workers) {}
+
+    void push(int worker, int task) {
+        lock_guard<mutex> guard(queues[worker].lock);
+        queues[worker].tasks.push_back(task);
+    }
+
+    bool pop(int worker, int &task) {
+        int n = queues.size();
+        for (int i = 0; i < n; i++) {
+            Queue &queue = queues[(worker + i) % n];
+            lock_guard<mutex> guard(queue.lock);
+            if (queue.tasks.empty()) {
+                continue;
+            }
+            //Own tasks from the front, stolen ones from the back
+            if (i == 0) {
+                task = queue.tasks.front();
+                queue.tasks.pop_front();
+            } else {
+                task = queue.tasks.back();
+                queue.tasks.pop_back();
             }
-            pacsNext.push_back(pacNext);
+            return true;
+        }
+        return false;
+    }
+};
+
+class Simulation {
+    Graph *graph;
+    int steps;
+    int threads;
+    int depth = 0;
+    int nbPacs = 0;
+    PelletBoard board;
+    //Pellets at the root of the previous run
+    PelletBoard previousRoot;
+    SearchArena arena;
+    vector<int> bestSimulation;
+    int bestTotal = NO_PLAN;
+    int completedDepth = 0;
+
+    //Deadline, the clock is only read every CLOCK_CHECK nodes
+    steady_clock::time_point deadline;
+    long nodes = 0;
+    bool timeout = false;
+
+    //Upper bound tables, indexed by remaining steps then cell
+    vector<int> reach;
+    vector<int> seen;
+    vector<int> queue;
+    vector<int> values;
+    vector<int> layerEnds;
+    const DistanceMatrix *distances = nullptr;
+
+    ZobristKeys zobrist;
+    TranspositionTable table;
+    bool carryTable = false;
+    //Part of the keys when there is danger, new every run so the entries depending on the danger of
+    //an earlier run are never read
+    uint64_t dangerKey = 0;
+    long runs = 0;
+
+    //Score lost by stepping on a cell at a given step, indexed by step then cell
+    EnemyField enemies;
+    vector<int> danger;
+    bool threatened = false;
+
+    //Parallel mode: workers search root moves on their own board and share the best total
+    vector<unique_ptr<Simulation>> workers;
+    atomic<int> sharedBest;
+    atomic<int> *incumbentTotal = nullptr;
+
+    //Worker threads live as long as the simulation, each round hands them the root moves of one depth
+    vector<thread> pool;
+    mutex poolLock;
+    condition_variable poolWake;
+    condition_variable poolDone;
+    int round = 0;
+    int running = 0;
+    bool stopping = false;
+    WorkStealingQueue *rootQueue = nullptr;
+    const vector<int> *rootMoves = nullptr;
+
+    //Best total known by this search or, in parallel mode, by any worker
+    int incumbent() const {
+        if (incumbentTotal == nullptr) {
+            return bestTotal;
         }
+        return max(bestTotal, incumbentTotal->load(memory_order_relaxed));
     }
 
-    bool hasCollision(vector<int> &source, vector<int> &dest) {
+    //Pac k moving to target collides with an already placed pac (same cell or crossing path)
+    bool hasCollision(const int *source, const int *dest, int k, int target) const {
+        for (int j = 0; j < k; j++) {
+            if (dest[j] == target || (dest[j] == source[k] && source[j] == target)) {
+                return true;
+            }
+        }
+        return false;
+    }
 
-        vector<bool> collided = vector<bool>(dest.size(), false);
+    //Best pellet total a pac on cell can still collect in the remaining steps
+    int upperBound(int cell, int remaining) const {
+        return reach[remaining * graph->getSize() + cell];
+    }
 
-        for (int i = 0; i < dest.size() - 1; i++) {
-            for (int j = i + 1; j < dest.size(); j++) {
-                //Going on the same cell
-                if (dest[i] == dest[j]) {
-                    return true;
+    //Cells within steps of cell ordered by distance, layer r ends at layerEnds[r]
+    void collectLayers(int cell) {
+        int size = graph->getSize();
+
+        if (distances != nullptr) {
+            //Counting sort of the matrix row
+            fill(layerEnds.begin(), layerEnds.end(), 0);
+            for (int other = 0; other < size; other++) {
+                int d = distances->distance(cell, other);
+                if (d <= steps) {
+                    layerEnds[d]++;
                 }
-                    //Crossing path
-                else if (dest[i] == source[j] && dest[j] == source[i]) {
-                    return true;
+            }
+            partial_sum(layerEnds.begin(), layerEnds.end(), layerEnds.begin());
+            int total = layerEnds[steps];
+            for (int other = size - 1; other >= 0; other--) {
+                int d = distances->distance(cell, other);
+                if (d <= steps) {
+                    queue[--layerEnds[d]] = other;
                 }
             }
+            //Ends were moved back to the starts, the end of a layer is the start of the next one
+            for (int r = 0; r < steps; r++) {
+                layerEnds[r] = layerEnds[r + 1];
+            }
+            layerEnds[steps] = total;
+            return;
         }
 
-        return false;
+        int head = 0, tail = 0;
+        queue[tail++] = cell;
+        seen[cell] = cell;
+        layerEnds[0] = tail;
+        for (int r = 1; r <= steps; r++) {
+            //Expand layer r - 1 into layer r
+            int layerEnd = tail;
+            while (head < layerEnd) {
+                int s = queue[head++];
+                for (int next: graph->getAdj(s)) {
+                    if (seen[next] != cell) {
+                        seen[next] = cell;
+                        queue[tail++] = next;
+                    }
+                }
+            }
+            layerEnds[r] = tail;
+        }
+    }
+
+    //For every cell and radius r, best pellets a path of r steps could pick, taking at step t
+    //the best pellet left within distance t (BFS layers).
+    //Pellets only disappear during the search so the bound stays admissible.
+    void computeReachBounds() {
+        int size = graph->getSize();
+        reach.assign((steps + 1) * size, 0);
+        seen.assign(size, -1);
+        queue.resize(size);
+        layerEnds.resize(steps + 1);
+
+        for (int cell = 0; cell < size; cell++) {
+            collectLayers(cell);
+            values.clear();
+            int sum = 0;
+
+            for (int r = 1; r <= steps; r++) {
+                for (int i = layerEnds[r - 1]; i < layerEnds[r]; i++) {
+                    values.push_back(board.value(queue[i]));
+                    push_heap(values.begin(), values.end());
+                }
+
+                if (!values.empty()) {
+                    pop_heap(values.begin(), values.end());
+                    sum += values.back();
+                    values.pop_back();
+                }
+                reach[r * size + cell] = sum;
+            }
+        }
+    }
+
+    bool expired() {
+        if (!timeout && (++nodes & (CLOCK_CHECK - 1)) == 0 && steady_clock::now() >= deadline) {
+            timeout = true;
+        }
+        return timeout;
+    }
+
+    //Penalty of entering cell at step, from the enemy forecast
+    void computeDanger() {
+        int size = graph->getSize();
+        danger.assign((steps + 1) * size, 0);
+        threatened = false;
+        for (int t = 0; t <= steps; t++) {
+            for (int c = 0; c < size; c++) {
+                danger[t * size + c] = (int) (enemies.presence(t, c) * ENEMY_RISK + 0.5f);
+                threatened = threatened || danger[t * size + c] > 0;
+            }
+        }
+    }
+
+    //Returns an upper bound of the score still reachable from this state, exact when nothing was cut
+    int doStep(int step, int total, uint64_t hash) {
+
+        if (expired()) {
+            return NO_PLAN;
+        }
+
+        int *source = arena.at(step);
+
+        if (step >= depth) {
+            if (total > bestTotal) {
+                bestSimulation.assign(source, source + nbPacs);
+                bestTotal = total;
+                if (incumbentTotal != nullptr) {
+                    int shared = incumbentTotal->load(memory_order_relaxed);
+                    while (total > shared && !incumbentTotal->compare_exchange_weak(shared, total)) {}
+                }
+            }
+            return 0;
+        }
+
+        int remaining = depth - step;
+
+        //Bound of the pacs not yet moved in this step, never more than the pellets left
+        int tails[MAX_PACS + 1];
+        tails[nbPacs] = 0;
+        for (int i = nbPacs - 1; i >= 0; i--) {
+            tails[i] = tails[i + 1] + upperBound(source[i], remaining);
+        }
+        int bound = min(tails[0], board.score());
+        int best = incumbent();
+        if (total + bound <= best) {
+            return bound;
+        }
+
+        //Same pacs positions and eaten pellets already searched through another move order.
+        //Nodes next to the leaves are cheaper to search than to look up.
+        //The danger depends on the step and the run so both are part of the key when there is any. The danger
+        //only lowers scores, a bound stored by an earlier run without danger still holds.
+        bool useTable = remaining >= TT_MIN_REMAINING;
+        uint64_t key = threatened ? hash ^ zobrist.step(step) ^ dangerKey : hash;
+        int cached;
+        if (useTable && (table.probe(key, remaining, cached) || (threatened && table.probe(hash, remaining, cached)))
+            && total + cached <= best) {
+            return cached;
+        }
+
+        int *dest = arena.at(step + 1);
+        int *eaten = arena.eatenAt(step);
+        int size = graph->getSize();
+        const int *risk = danger.data() + (step + 1) * size;
+
+        //Moves of each pac, best bound first so good plans are found early
+        int moves[MAX_PACS][MAX_NEIGHBORS];
+        int scores[MAX_PACS][MAX_NEIGHBORS];
+        int nbMoves[MAX_PACS];
+        for (int i = 0; i < nbPacs; i++) {
+            Neighbors adj = graph->getAdj(source[i]);
+            nbMoves[i] = min(adj.size(), MAX_NEIGHBORS);
+            for (int m = 0; m < nbMoves[i]; m++) {
+                int move = adj[m];
+                int score = board.value(move) - risk[move] + upperBound(move, remaining - 1);
+                int j = m;
+                while (j > 0 && scores[i][j - 1] < score) {
+                    moves[i][j] = moves[i][j - 1];
+                    scores[i][j] = scores[i][j - 1];
+                    j--;
+                }
+                moves[i][j] = move;
+                scores[i][j] = score;
+            }
+        }
+
+        //Odometer over the joint moves, one digit per pac, filled left to right
+        int indices[MAX_PACS];
+        int gains[MAX_PACS + 1];
+        int optimistic[MAX_PACS + 1];
+        uint64_t hashes[MAX_PACS + 1];
+        int upper = NO_PLAN;
+
+        int k = 0;
+        indices[0] = 0;
+        gains[0] = total;
+        optimistic[0] = total;
+        hashes[0] = hash;
+
+        while (k >= 0) {
+            if (indices[k] >= nbMoves[k]) {
+                //Digit exhausted, carry into the previous pac
+                k--;
+                if (k >= 0) {
+                    board.put(dest[k], eaten[k]);
+                    indices[k]++;
+                }
+                continue;
+            }
+
+            int target = moves[k][indices[k]];
+            if (hasCollision(source, dest, k, target)) {
+                indices[k]++;
+                continue;
+            }
+
+            //Moves are sorted by score, once one cannot beat the best the next ones cannot either
+            optimistic[k + 1] = optimistic[k] + scores[k][indices[k]];
+            if (optimistic[k + 1] + tails[k + 1] <= best) {
+                upper = max(upper, optimistic[k + 1] + tails[k + 1] - total);
+                indices[k] = nbMoves[k];
+                continue;
+            }
+
+            //Take the pellet
+            dest[k] = target;
+            eaten[k] = board.take(target);
+            gains[k + 1] = gains[k] + eaten[k] - risk[target];
+            hashes[k + 1] = hashes[k] ^ zobrist.pac(k, source[k]) ^ zobrist.pac(k, target);
+            if (eaten[k] > 0) {
+                hashes[k + 1] ^= zobrist.pellet(target);
+            }
+
+            if (k + 1 < nbPacs) {
+                k++;
+                indices[k] = 0;
+            } else {
+                int child = doStep(step + 1, gains[nbPacs], hashes[nbPacs]);
+                if (child != NO_PLAN) {
+                    upper = max(upper, gains[nbPacs] - total + child);
+                }
+                best = incumbent();
+                board.put(target, eaten[k]);
+                indices[k]++;
+
+                if (timeout) {
+                    //Unwind the pacs already placed so the board is left untouched
+                    for (int i = k - 1; i >= 0; i--) {
+                        board.put(dest[i], eaten[i]);
+                    }
+                    return NO_PLAN;
+                }
+            }
+        }
+
+        if (useTable) {
+            table.store(key, remaining, upper);
+        }
+        return upper;
+    }
+
+    //Legal joint moves of the root, nbPacs cells per move
+    void collectRootMoves(int k, vector<int> &moves) {
+        int *source = arena.at(0);
+        int *dest = arena.at(1);
+        if (k == nbPacs) {
+            moves.insert(moves.end(), dest, dest + nbPacs);
+            return;
+        }
+        for (int target: graph->getAdj(source[k])) {
+            if (!hasCollision(source, dest, k, target)) {
+                dest[k] = target;
+                collectRootMoves(k + 1, moves);
+            }
+        }
+    }
+
+    //Worker side: play one root joint move on the own board and search below it
+    void searchRootMove(const int *move) {
+        int *source = arena.at(0);
+        int *dest = arena.at(1);
+        int *eaten = arena.eatenAt(0);
+        int size = graph->getSize();
+
+        int total = 0;
+        uint64_t hash = zobrist.state(source, nbPacs);
+        for (int i = 0; i < nbPacs; i++) {
+            dest[i] = move[i];
+            eaten[i] = board.take(move[i]);
+            total += eaten[i] - danger[size + move[i]];
+            hash ^= zobrist.pac(i, source[i]) ^ zobrist.pac(i, move[i]);
+            if (eaten[i] > 0) {
+                hash ^= zobrist.pellet(move[i]);
+            }
+        }
+
+        doStep(1, total, hash);
+
+        for (int i = 0; i < nbPacs; i++) {
+            board.put(move[i], eaten[i]);
+        }
+    }
+
+    //Copy the root state of this run into a worker
+    void prepareWorker(Simulation &worker) {
+        worker.nbPacs = nbPacs;
+        worker.deadline = deadline;
+        worker.board = board;
+        worker.reach = reach;
+        worker.danger = danger;
+        worker.threatened = threatened;
+        worker.dangerKey = dangerKey;
+        worker.distances = distances;
+        worker.zobrist = zobrist;
+        if (carryTable) {
+            worker.table.age();
+        } else {
+            worker.table.clear();
+        }
+        worker.arena.reset(steps, nbPacs);
+        copy(arena.at(0), arena.at(0) + nbPacs, worker.arena.at(0));
+        worker.incumbentTotal = &sharedBest;
+    }
+
+    //Search the current depth with the root moves split across the workers
+    void searchParallel() {
+        vector<int> moves;
+        collectRootMoves(0, moves);
+        int nbRoot = moves.size() / max(nbPacs, 1);
+
+        //Most promising root moves first
+        vector<pair<int, int>> order;
+        for (int m = 0; m < nbRoot; m++) {
+            int score = 0;
+            for (int i = 0; i < nbPacs; i++) {
+                int cell = moves[m * nbPacs + i];
+                score += board.value(cell) - danger[graph->getSize() + cell] + upperBound(cell, depth - 1);
+            }
+            order.emplace_back(-score, m);
+        }
+        sort(order.begin(), order.end());
+
+        WorkStealingQueue queue(threads);
+        for (int m = 0; m < nbRoot; m++) {
+            queue.push(m % threads, order[m].second);
+        }
+        sharedBest.store(NO_PLAN);
+
+        for (int w = 0; w < threads; w++) {
+            Simulation &worker = *workers[w];
+            worker.depth = depth;
+            worker.nodes = 0;
+            worker.timeout = false;
+            worker.bestSimulation.clear();
+            worker.bestTotal = NO_PLAN;
+        }
+        {
+            lock_guard<mutex> guard(poolLock);
+            rootQueue = &queue;
+            rootMoves = &moves;
+            running = threads;
+            round++;
+        }
+        poolWake.notify_all();
+        unique_lock<mutex> guard(poolLock);
+        poolDone.wait(guard, [this]() { return running == 0; });
+
+        for (auto &worker: workers) {
+            nodes += worker->nodes;
+            timeout = timeout || worker->timeout;
+            if (worker->bestTotal > bestTotal) {
+                bestTotal = worker->bestTotal;
+                bestSimulation = worker->bestSimulation;
+            }
+        }
+    }
+
+    //Thread body of worker w: waits for a round, searches root moves until the queue is empty
+    void serve(int w) {
+        Simulation &worker = *workers[w];
+        int served = 0;
+        unique_lock<mutex> guard(poolLock);
+        while (true) {
+            poolWake.wait(guard, [this, served]() { return stopping || round != served; });
+            if (stopping) {
+                return;
+            }
+            served = round;
+            guard.unlock();
+            int task;
+            while (!worker.timeout && rootQueue->pop(w, task)) {
+                worker.searchRootMove(&(*rootMoves)[task * nbPacs]);
+            }
+            guard.lock();
+            if (--running == 0) {
+                poolDone.notify_one();
+            }
+        }
     }
 
 public:
-    Simulation(Graph *graph, int steps) : graph(graph), steps(steps) {}
+    Simulation(Graph *graph, int steps, int threads = 1) : graph(graph), steps(steps), threads(threads),
+                                                           table(TT_BITS) {}
+
+    ~Simulation() {
+        {
+            lock_guard<mutex> guard(poolLock);
+            stopping = true;
+        }
+        poolWake.notify_all();
+        for (auto &t: pool) {
+            t.join();
+        }
+    }
+
+    //Iterative deepening up to steps, returns the plan of the deepest search completed within budget
+    vector<int> run(vector<int> myPacs, vector<int> enemyPacs, int *pellets,
+                    steady_clock::duration budget = steady_clock::duration::max()) {
 
-    vector<int> run(vector<int> myPacs, vector<int> enemyPacs, int *pellets) {
+        deadline = budget == steady_clock::duration::max() ? steady_clock::time_point::max()
+                                                             : steady_clock::now() + budget;
+        nodes = 0;
+        timeout = false;
 
-        bool *visited = new bool[graph->getSize() * myPacs.size()];
-        for (int i = 0; i < graph->getSize() * myPacs.size(); i++) {
-            visited[i] = false;
+        nbPacs = min((int) myPacs.size(), MAX_PACS);
+        arena.reset(steps, nbPacs);
+
+        int size = graph->getSize();
+        board.reset(pellets, size);
+        int *start = arena.at(0);
+        for (int i = 0; i < nbPacs; i++) {
+            start[i] = myPacs[i];
+        }
+        computeReachBounds();
+        zobrist.resize(size, steps);
+
+        //Enemy field persists between turns
+        enemies.attach(*graph, steps);
+        enemies.observe(enemyPacs);
+        computeDanger();
+
+        //Bounds stored by the previous runs stay admissible while no pellet reappeared, the table then carries over
+        dangerKey = ++runs * 0x9E3779B97F4A7C15ULL;
+        carryTable = board.within(previousRoot);
+        previousRoot = board;
+        if (carryTable) {
+            table.age();
+        } else {
+            table.clear();
         }
-        for (int i = 0; i < myPacs.size(); i++) {
-            visited[i * graph->getSize() + myPacs[i]] = true;
+
+        if (threads > 1) {
+            while ((int) workers.size() < threads) {
+                workers.emplace_back(new Simulation(graph, steps));
+            }
+            while ((int) pool.size() < threads) {
+                pool.emplace_back(&Simulation::serve, this, (int) pool.size());
+            }
+            for (auto &worker: workers) {
+                prepareWorker(*worker);
+            }
+        }
+
+        vector<int> result;
+        int resultTotal = NO_PLAN;
+        completedDepth = 0;
+        for (depth = 1; depth <= steps; depth++) {
+            bestSimulation.clear();
+            bestTotal = NO_PLAN;
+            if (threads > 1) {
+                searchParallel();
+            } else {
+                doStep(0, 0, zobrist.state(start, nbPacs));
+            }
+            if (timeout) {
+                break;
+            }
+            result = bestSimulation;
+            resultTotal = bestTotal;
+            completedDepth = depth;
         }
-        vector<int> bestSimulation;
-        int bestTotal = -1;
-        doStep(myPacs, 0, bestSimulation, bestTotal, pellets, visited, 0);
+        bestTotal = resultTotal;
+
+        return result;
+    }
+
+    //Use precomputed distances instead of a BFS per cell
+    void setDistances(const DistanceMatrix *matrix) {
+        distances = matrix;
+    }
 
-        return bestSimulation;
+    int getBestTotal() const {
+        return bestTotal;
+    }
+
+    int getCompletedDepth() const {
+        return completedDepth;
+    }
+
+    long getNodes() const {
+        return nodes;
     }
 
 
 };
 
-class Edge {
-    int src, dest;
+//Xorshift generator for the rollouts
+class FastRandom {
+    uint64_t state;
+
 public:
-    Edge(int src, int dest) : src(src), dest(dest) {}
+    explicit FastRandom(uint64_t seed) : state(seed ? seed : 0x9E3779B97F4A7C15ULL) {}
 
-    int getSrc() const {
-        return src;
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state >> 32;
     }
 
-    int getDest() const {
-        return dest;
+    int below(int n) {
+        return (int) (((uint64_t) next() * n) >> 32);
     }
 };
 
-class PointRegister {
-    int currentIndex = 0;
-    map<int, pair<int, int>> toPoint;
-    map<pair<int, int>, int> toIndex;
-public:
-    pair<int, int> getPoint(int index) {
-        return toPoint[index];
+//Decoupled UCT: one tree per pac over its own moves, the pacs share the joint rollouts and the team
+//reward. Nodes come from a preallocated pool, the children of a node are contiguous.
+class MctsSimulation {
+    struct Node {
+        int cell;
+        int firstChild;
+        int nbChildren;
+        int visits;
+        float total;
+    };
+
+    Graph *graph;
+    int steps;
+    int nbPacs = 0;
+    PelletBoard board;
+    FastRandom random = FastRandom(MCTS_SEED);
+    vector<Node> pool;
+    int used = 0;
+    long iterations = 0;
+
+    //Per iteration: positions of the pacs, nodes visited by each tree, pellets taken to undo
+    int roots[MAX_PACS];
+    int positions[MAX_PACS];
+    int moved[MAX_PACS];
+    //Enemies seen this turn, assumed to stay where they are
+    int enemies[MAX_PACS];
+    int nbEnemies = 0;
+    vector<int> paths[MAX_PACS];
+    vector<pair<int, int>> taken;
+
+    int newNode(int cell) {
+        pool[used] = Node{cell, -1, 0, 0, 0.0f};
+        return used++;
     }
 
-    int getIndex(pair<int, int> point) {
-        if (toIndex.find(point) == toIndex.end()) {
-            toPoint[currentIndex] = point;
-            toIndex[point] = currentIndex++;
+    //Children of a node are all the neighbors of its cell, false once the pool is full
+    bool expand(int node) {
+        Neighbors adj = graph->getAdj(pool[node].cell);
+        if (used + adj.size() > (int) pool.size()) {
+            return false;
+        }
+        pool[node].firstChild = used;
+        pool[node].nbChildren = adj.size();
+        for (int next: adj) {
+            newNode(next);
+        }
+        return true;
+    }
 
+    //Pac k moving to target collides with a pac already moved in this step (same cell or crossing path)
+    //or with an enemy
+    bool hasCollision(int k, int target) const {
+        for (int j = 0; j < k; j++) {
+            if (moved[j] == target || (moved[j] == positions[k] && positions[j] == target)) {
+                return true;
+            }
         }
-        return toIndex[point];
+        for (int e = 0; e < nbEnemies; e++) {
+            if (enemies[e] == target) {
+                return true;
+            }
+        }
+        return false;
     }
 
-    int size() {
-        return currentIndex;
+    //UCB1 child not colliding with the pacs already moved, unvisited children first, -1 if none
+    int select(int k, int node) {
+        const Node &parent = pool[node];
+        float logVisits = log((float) max(parent.visits, 1));
+        int best = -1;
+        float bestValue = -1.0f;
+        for (int c = parent.firstChild; c < parent.firstChild + parent.nbChildren; c++) {
+            const Node &child = pool[c];
+            if (hasCollision(k, child.cell)) {
+                continue;
+            }
+            float value = child.visits == 0
+                          ? 1e9f + random.below(1024)
+                          : child.total / child.visits + MCTS_EXPLORATION * sqrt(logVisits / child.visits);
+            if (value > bestValue) {
+                bestValue = value;
+                best = c;
+            }
+        }
+        return best;
     }
 
+    int eat(int cell) {
+        int value = board.take(cell);
+        if (value > 0) {
+            taken.emplace_back(cell, value);
+        }
+        return value;
+    }
 
-};
+    //Random moves until the horizon, a pac with no free neighbor stays
+    int rollout(int step) {
+        int gained = 0;
+        for (; step < steps; step++) {
+            for (int k = 0; k < nbPacs; k++) {
+                Neighbors adj = graph->getAdj(positions[k]);
+                moved[k] = positions[k];
+                int first = random.below(adj.size());
+                for (int m = 0; m < adj.size(); m++) {
+                    int target = adj[(first + m) % adj.size()];
+                    if (!hasCollision(k, target)) {
+                        moved[k] = target;
+                        break;
+                    }
+                }
+            }
+            for (int k = 0; k < nbPacs; k++) {
+                positions[k] = moved[k];
+                gained += eat(positions[k]);
+            }
+        }
+        return gained;
+    }
 
+    void iterate() {
+        taken.clear();
+        int gained = 0;
+        int step = 0;
+        for (int k = 0; k < nbPacs; k++) {
+            paths[k].clear();
+            paths[k].push_back(roots[k]);
+            positions[k] = pool[roots[k]].cell;
+        }
 
-class FirstPelletSimulation {
-    Graph &graph;
-
-    int findTarget(int pac, vector<int> &myPacs, vector<int> &enemyPacs, int *pellets) {
-        bool *visited = new bool[graph.getSize()];
-        for (int i = 0; i < graph.getSize(); i++) {
-            if (find(myPacs.begin(), myPacs.end(), i) != myPacs.end()) {
-                visited[i] = true;
-            } else if (find(enemyPacs.begin(), enemyPacs.end(), i) != enemyPacs.end()) {
-                visited[i] = true;
-            } else {
-                visited[i] = false;
+        //Tree phase: every pac descends its own tree until one of them reaches a new node
+        bool inTree = true;
+        while (inTree && step < steps) {
+            int chosen[MAX_PACS];
+            for (int k = 0; k < nbPacs && inTree; k++) {
+                int node = paths[k].back();
+                if (pool[node].nbChildren == 0 && !expand(node)) {
+                    inTree = false;
+                    break;
+                }
+                chosen[k] = select(k, node);
+                if (chosen[k] < 0) {
+                    inTree = false;
+                    break;
+                }
+                moved[k] = pool[chosen[k]].cell;
+            }
+            if (!inTree) {
+                break;
+            }
+            for (int k = 0; k < nbPacs; k++) {
+                inTree = inTree && pool[chosen[k]].visits > 0;
+                paths[k].push_back(chosen[k]);
+                positions[k] = moved[k];
+                gained += eat(positions[k]);
             }
+            step++;
         }
 
-        list<int> queue;
-        queue.push_back(pac);
+        gained += rollout(step);
 
-        while (queue.size() > 0) {
+        //Team reward, about one pellet per pac and step at best
+        float reward = gained / (float) (nbPacs * steps);
+        for (int k = 0; k < nbPacs; k++) {
+            for (int node: paths[k]) {
+                pool[node].visits++;
+                pool[node].total += reward;
+            }
+        }
 
-            int s = queue.front();
-            queue.pop_front();
+        for (auto &pellet: taken) {
+            board.put(pellet.first, pellet.second);
+        }
+    }
 
-            for (auto a: graph.getAdj(s)) {
-                if (pellets[a] > 0) {
-                    return a;
-                }
-                if (!visited[a]) {
-                    queue.push_back(a);
-                    visited[a] = true;
+    //Most visited line of a tree down to the horizon
+    int target(int root) const {
+        int node = root;
+        while (pool[node].nbChildren > 0) {
+            int best = -1;
+            for (int c = pool[node].firstChild; c < pool[node].firstChild + pool[node].nbChildren; c++) {
+                if (pool[c].visits > 0 && (best < 0 || pool[c].visits > pool[best].visits)) {
+                    best = c;
                 }
+            }
+            if (best < 0) {
+                break;
+            }
+            node = best;
+        }
+        return pool[node].cell;
+    }
+
+public:
+    MctsSimulation(Graph *graph, int steps) : graph(graph), steps(steps), pool(MCTS_POOL) {
+        taken.reserve(steps * MAX_PACS);
+        for (auto &path: paths) {
+            path.reserve(steps + 1);
+        }
+    }
+
+    vector<int> run(vector<int> &myPacs, vector<int> &enemyPacs, int *pellets,
+                    steady_clock::duration budget = milliseconds(SIM_BUDGET_MS)) {
+
+        auto deadline = steady_clock::now() + budget;
+        nbPacs = min((int) myPacs.size(), MAX_PACS);
+        nbEnemies = min((int) enemyPacs.size(), MAX_PACS);
+        copy(enemyPacs.begin(), enemyPacs.begin() + nbEnemies, enemies);
+        board.reset(pellets, graph->getSize());
+        used = 0;
+        iterations = 0;
+        for (int k = 0; k < nbPacs; k++) {
+            roots[k] = newNode(myPacs[k]);
+        }
+
+        do {
+            for (int i = 0; i < MCTS_CLOCK_CHECK; i++) {
+                iterate();
+            }
+            iterations += MCTS_CLOCK_CHECK;
+        } while (steady_clock::now() < deadline);
+
+        vector<int> result;
+        for (int k = 0; k < nbPacs; k++) {
+            result.push_back(target(roots[k]));
+        }
+        return result;
+    }
+
+    long getIterations() const {
+        return iterations;
+    }
+};
+
+//Dense grid to cell index lookup, cells are registered by Map::buildGraph in row-major order
+class PointRegister {
+    int width = 0;
+    int height = 0;
+    vector<int> cellIndex;
+    vector<pair<int, int>> points;
+public:
+    void reset(int width, int height) {
+        this->width = width;
+        this->height = height;
+        cellIndex.assign(width * height, -1);
+        points.clear();
+    }
 
+    int add(pair<int, int> point) {
+        cellIndex[point.second * width + point.first] = points.size();
+        points.push_back(point);
+        return points.size() - 1;
+    }
+
+    pair<int, int> getPoint(int index) const {
+        return points[index];
+    }
+
+    //Cell index of the point, -1 on walls and outside the grid
+    int getIndex(pair<int, int> point) const {
+        if (point.first < 0 || point.first >= width || point.second < 0 || point.second >= height) {
+            return -1;
+        }
+        return cellIndex[point.second * width + point.first];
+    }
+
+    const vector<int> &getCells() const {
+        return cellIndex;
+    }
+
+    int size() const {
+        return points.size();
+    }
+
+
+};
+
+
+//Buffered tokenizer over stdin, reads only what is available so it never waits past the end of a turn
+class InputReader {
+    char buffer[1 << 16];
+    int position = 0;
+    int length = 0;
+
+    int peek() {
+        if (position == length) {
+            position = 0;
+            length = max((int) read(0, buffer, sizeof(buffer)), 0);
+            if (length == 0) {
+                return -1;
             }
+        }
+        return (unsigned char) buffer[position];
+    }
 
+public:
+    //False at the end of the input
+    bool skipSpaces() {
+        int c;
+        while ((c = peek()) != -1 && c <= ' ') {
+            position++;
         }
-        return pac;
+        return c != -1;
+    }
 
+    int nextInt() {
+        skipSpaces();
+        bool negative = peek() == '-';
+        if (negative) {
+            position++;
+        }
+        int value = 0;
+        int c;
+        while ((c = peek()) >= '0' && c <= '9') {
+            value = value * 10 + c - '0';
+            position++;
+        }
+        return negative ? -value : value;
+    }
+
+    void nextWord(string &word) {
+        word.clear();
+        skipSpaces();
+        int c;
+        while ((c = peek()) > ' ') {
+            word.push_back((char) c);
+            position++;
+        }
+    }
+
+    //Rest of the current line without the line break, leading spaces included
+    void nextLine(string &line) {
+        line.clear();
+        int c;
+        while ((c = peek()) != -1 && c != '\n') {
+            if (c != '\r') {
+                line.push_back((char) c);
+            }
+            position++;
+        }
+        if (c == '\n') {
+            position++;
+        }
     }
+};
+
+class FirstPelletSimulation {
+    DistanceField &field;
 
 public:
-    FirstPelletSimulation(Graph &graph) : graph(graph) {}
+    FirstPelletSimulation(DistanceField &field) : field(field) {}
 
     vector<int> run(vector<int> &myPacs, vector<int> &enemyPacs, int *pellets) {
 
         vector<int> result;
 
+        //Pacs block the way for the others
+        vector<int> pacs = myPacs;
+        pacs.insert(pacs.end(), enemyPacs.begin(), enemyPacs.end());
+        field.setBlocked(pacs);
+        field.setTargets(pellets);
+
         for (auto pac:myPacs) {
-            result.push_back(findTarget(pac, myPacs, enemyPacs, pellets));
+            result.push_back(field.nearestTarget(pac));
         }
 
         return result;
@@ -324,31 +1613,53 @@ public:
     }
 
     Graph buildGraph() {
-        vector<Edge> edges;
+        paths.reset(width, height);
         for (int y = 0; y < height; y++) {
             for (int x = 0; x < width; x++) {
                 if (rows[y][x] == ' ') {
+                    paths.add(make_pair(x, y));
+                }
+            }
+        }
 
-                    int index = paths.getIndex(make_pair(x, y));
+        //Neighbors up, left, right, down, wrapping around the borders
+        const int dx[] = {0, -1, 1, 0};
+        const int dy[] = {-1, 0, 0, 1};
 
-                    for (pair<int, int> d_point: {make_pair(x, (y - 1) % height), make_pair((x - 1) % width, y)}) {
-                        if (rows[d_point.second][d_point.first] == ' ') {
-                            int d_index = paths.getIndex(d_point);
-                            edges.emplace_back(Edge(index, d_index));
-                        }
+        vector<int> offsets(1, 0);
+        vector<int> neighbors;
+        vector<bool> tunnels;
+        offsets.reserve(paths.size() + 1);
+        neighbors.reserve(paths.size() * MAX_NEIGHBORS);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                int index = paths.getIndex(make_pair(x, y));
+                if (index < 0) {
+                    continue;
+                }
+                for (int d = 0; d < MAX_NEIGHBORS; d++) {
+                    int nx = (x + dx[d] + width) % width;
+                    int ny = (y + dy[d] + height) % height;
+                    int n_index = paths.getIndex(make_pair(nx, ny));
+                    if (n_index >= 0 && n_index != index) {
+                        neighbors.push_back(n_index);
+                        tunnels.push_back(nx != x + dx[d] || ny != y + dy[d]);
                     }
                 }
+                offsets.push_back(neighbors.size());
             }
         }
 
-        Graph graph = Graph(paths.size());
-        for (Edge edge: edges) {
-            int x = edge.getSrc();
-            int y = edge.getDest();
-            graph.addEdge(x, y);
-            graph.addEdge(y, x);
+        return Graph(move(offsets), move(neighbors), move(tunnels));
+    }
+
+    DistanceField buildDistanceField() {
+        vector<int> positions(paths.size());
+        for (int i = 0; i < paths.size(); i++) {
+            pair<int, int> point = paths.getPoint(i);
+            positions[i] = point.second * width + point.first;
         }
-        return graph;
+        return DistanceField(width, height, paths.getCells(), positions);
     }
 
     pair<int, int> getPoint(int index) {
@@ -363,6 +1674,32 @@ public:
         return paths.getIndex(make_pair(x, y));
     }
 
+    //Cells in line of sight of each cell, straight in the four directions up to a wall, as offsets into cells
+    void buildSight(vector<int> &offsets, vector<int> &cells) {
+        const int dx[] = {0, -1, 1, 0};
+        const int dy[] = {-1, 0, 0, 1};
+
+        offsets.assign(1, 0);
+        cells.clear();
+        for (int i = 0; i < paths.size(); i++) {
+            pair<int, int> point = paths.getPoint(i);
+            for (int d = 0; d < MAX_NEIGHBORS; d++) {
+                int x = point.first;
+                int y = point.second;
+                while (true) {
+                    x = (x + dx[d] + width) % width;
+                    y = (y + dy[d] + height) % height;
+                    int index = paths.getIndex(make_pair(x, y));
+                    if (index < 0 || index == i) {
+                        break;
+                    }
+                    cells.push_back(index);
+                }
+            }
+            offsets.push_back(cells.size());
+        }
+    }
+
     void printIndex() {
         for (int i = 0; i < paths.size(); i++) {
             pair<int, int> point = paths.getPoint(i);
@@ -371,6 +1708,7 @@ public:
         }
     }
 
+    //-1 for points that are not an open cell
     void toIndex(vector<pair<int,int>>& src, vector<int>& dest){
         for_each(src.begin(), src.end(), [&](pair<int, int> &p) { dest.emplace_back(paths.getIndex(p)); });
     }
@@ -383,7 +1721,7 @@ public:
         toIndex(pacs,pacIndex);
         toIndex(enemy,enemyIndex);
 
-        vector<int> nextValues = sim.run(pacIndex, enemyIndex, pellets);
+        vector<int> nextValues = sim.run(pacIndex, enemyIndex, pellets, milliseconds(SIM_BUDGET_MS));
         vector<pair<int, int>> results;
         for (auto val:nextValues) {
             results.push_back(paths.getPoint(val));
@@ -410,60 +1748,350 @@ public:
 };
 
 
-int main() {
+//Pellets known to the bot, kept across turns and updated from what the pacs see.
+//Unseen cells keep their last known value, floor cells start with a pellet.
+class PelletTracker {
+    vector<int> pellets;
+    vector<int> reported;
+    vector<int> sightOffsets;
+    vector<int> sightCells;
+    vector<int> superCells;
+    int turn = 0;
 
-    auto start = std::chrono::steady_clock::now();
+public:
+    void reset(Map &pacMap, int size) {
+        pellets.assign(size, 1);
+        reported.assign(size, -1);
+        pacMap.buildSight(sightOffsets, sightCells);
+        superCells.clear();
+        turn = 0;
+    }
 
-    int width;
-    int height;
-    cin >> width >> height;
-    cin.ignore();
+    void beginTurn() {
+        turn++;
+    }
+
+    void observe(int cell, int value) {
+        pellets[cell] = value;
+        reported[cell] = turn;
+        //Every super pellet is visible on the first turn
+        if (turn == 1 && value > 1) {
+            superCells.push_back(cell);
+        }
+    }
+
+    //Cells a pac stands on or sees without a pellet reported this turn are empty
+    void look(int cell) {
+        pellets[cell] = 0;
+        for (int i = sightOffsets[cell]; i < sightOffsets[cell + 1]; i++) {
+            if (reported[sightCells[i]] != turn) {
+                pellets[sightCells[i]] = 0;
+            }
+        }
+    }
+
+    void clear(int cell) {
+        pellets[cell] = 0;
+    }
+
+    //Super pellets are always visible, the ones missing were eaten
+    void endTurn() {
+        for (int cell: superCells) {
+            if (reported[cell] != turn) {
+                pellets[cell] = 0;
+            }
+        }
+    }
+
+    int *data() {
+        return pellets.data();
+    }
+};
+
+
+#ifndef BENCHMARK
+
+//Game loop: the map, graph, distances and planners are built once, each turn only updates
+//the pellets and pacs from the input before searching.
+int main() {
+    InputReader in;
+
+    int width = in.nextInt();
+    int height = in.nextInt();
+    string row;
+    in.nextLine(row);
 
     Map pacMap = Map(width, height);
     for (int i = 0; i < height; i++) {
-        string row;
-        getline(cin, row);
-        cout << row << endl;
+        in.nextLine(row);
         pacMap.addRow(row);
     }
 
-
     Graph graph = pacMap.buildGraph();
+    DistanceField field = pacMap.buildDistanceField();
+    DistanceMatrix distances = DistanceMatrix(field);
+
+    Simulation sim = Simulation(&graph, SIM_STEPS);
+    sim.setDistances(&distances);
+    FirstPelletSimulation fallback = FirstPelletSimulation(field);
+
+    PelletTracker pellets;
+    pellets.reset(pacMap, graph.getSize());
+
+    vector<int> pacIds;
+    vector<int> pacs;
+    vector<int> enemy;
+    string typeId;
+    string command;
+
+    while (in.skipSpaces()) {
+        in.nextInt();
+        //Budget runs from the first byte of the turn
+        auto start = steady_clock::now();
+        in.nextInt();
+
+        pacIds.clear();
+        pacs.clear();
+        enemy.clear();
+        pellets.beginTurn();
+
+        int visiblePacCount = in.nextInt();
+        for (int i = 0; i < visiblePacCount; i++) {
+            int pacId = in.nextInt();
+            int mine = in.nextInt();
+            int x = in.nextInt();
+            int y = in.nextInt();
+            in.nextWord(typeId);
+            in.nextInt();
+            in.nextInt();
+            if (typeId == "DEAD") {
+                continue;
+            }
+            int cell = pacMap.getIndex(x, y);
+            if (mine) {
+                pacIds.push_back(pacId);
+                pacs.push_back(cell);
+            } else {
+                enemy.push_back(cell);
+            }
+        }
 
-    FirstPelletSimulation sim = FirstPelletSimulation(graph);
-
-    vector<pair<int, int>> pacs = {make_pair(0, 1), make_pair(5, 3), make_pair(9, 5), make_pair(5, 9)};
-    vector<pair<int, int>> enemy = {make_pair(15, 7), make_pair(15, 3)};
-    vector<int> pellets10 = {1};
-    int *pellets = new int[graph.getSize()];
-    for (int i = 0; i < graph.getSize(); i++) {
-        if (find(pacs.begin(), pacs.end(), pacMap.getPoint(i)) != pacs.end()) {
-            pellets[i] = 0;
-        } else if (find(pellets10.begin(), pellets10.end(), i) != pellets10.end()) {
-            pellets[i] = 10;
-        } else {
-            pellets[i] = 1;
+        int visiblePelletCount = in.nextInt();
+        for (int i = 0; i < visiblePelletCount; i++) {
+            int x = in.nextInt();
+            int y = in.nextInt();
+            pellets.observe(pacMap.getIndex(x, y), in.nextInt());
         }
 
-    }
+        for (int cell: pacs) {
+            pellets.look(cell);
+        }
+        for (int cell: enemy) {
+            pellets.clear(cell);
+        }
+        pellets.endTurn();
 
+        auto budget = milliseconds(SIM_BUDGET_MS) - (steady_clock::now() - start);
+        vector<int> targets = sim.run(pacs, enemy, pellets.data(), budget);
+        if (targets.size() < pacs.size()) {
+            targets = fallback.run(pacs, enemy, pellets.data());
+        }
+
+        command.clear();
+        for (int i = 0; i < (int) pacs.size(); i++) {
+            pair<int, int> point = pacMap.getPoint(targets[i]);
+            if (i > 0) {
+                command += " | ";
+            }
+            command += "MOVE " + to_string(pacIds[i]) + " " + to_string(point.first) + " " + to_string(point.second);
+        }
+        cout << command << endl;
 
-    for (auto pac:pacs) {
-        cout << "(" << pac.first << "," << pac.second << ") ";
+        cerr << "depth " << sim.getCompletedDepth() << " nodes " << sim.getNodes() << " "
+             << duration_cast<microseconds>(steady_clock::now() - start).count() / 1000.0 << "ms" << endl;
     }
-    cout << endl;
+}
+
+#else
+
+//Benchmark: replays the turns of the corpus files given on the command line, in order, through the planners
+//at several depths and pac counts. -t sets the threads of the search.
+//  g++ -std=c++17 -O2 -pthread -DBENCHMARK map.cpp -o map_bench && ./map_bench [-t threads] map_corpus/*.txt
+//Corpus files hold the map header followed by turns in the game input format.
+
+struct BenchPosition {
+    vector<pair<int, int>> pacs;
+    vector<pair<int, int>> enemy;
+    vector<pair<pair<int, int>, int>> pellets;
+};
 
-    vector<pair<int, int>> s = pacMap.next(sim, pacs, enemy, pellets);
-    for (auto i:s) {
+struct BenchStats {
+    vector<double> millis;
+    double work = 0;
+    double depth = 0;
+    double quality = 0;
 
-        cout << "(" << i.first << "," << i.second << ") ";
+    double percentile(double p) {
+        sort(millis.begin(), millis.end());
+        int rank = (int) ceil(p * millis.size()) - 1;
+        return millis[max(rank, 0)];
     }
-    cout << endl;
+};
 
+//Pellets collected when every pac walks a shortest path towards its target for steps moves
+int planQuality(const DistanceMatrix &distances, Graph &graph, vector<int> pacs, const vector<int> &targets,
+                vector<int> pellets, int steps) {
+    int total = 0;
+    for (int s = 0; s < steps; s++) {
+        for (int k = 0; k < (int) pacs.size(); k++) {
+            for (int next: graph.getAdj(pacs[k])) {
+                if (distances.distance(next, targets[k]) < distances.distance(pacs[k], targets[k])) {
+                    pacs[k] = next;
+                    break;
+                }
+            }
+            total += pellets[pacs[k]];
+            pellets[pacs[k]] = 0;
+        }
+    }
+    return total;
+}
+
+//Times one planner run and adds it to stats, quality is measured over steps moves
+template<typename Run>
+void benchRun(BenchStats &stats, const DistanceMatrix &distances, Graph &graph, const vector<int> &pacs,
+              const vector<int> &pellets, int steps, Run run) {
+    auto start = steady_clock::now();
+    double work = 0, reached = 0;
+    vector<int> targets = run(work, reached);
+    stats.millis.push_back(duration_cast<microseconds>(steady_clock::now() - start).count() / 1000.0);
+    stats.work += work;
+    stats.depth += reached;
+    stats.quality += planQuality(distances, graph, pacs, targets, pellets, steps);
+}
+
+int main(int argc, char **argv) {
+    const int depths[] = {4, 8, 12};
+    const int pacCounts[] = {1, 3, 5};
+    const int repeats = 3;
+
+    int threads = 1;
+    int firstFile = 1;
+    if (argc > 2 && string(argv[1]) == "-t") {
+        threads = max(atoi(argv[2]), 1);
+        firstFile = 3;
+    }
 
-    auto end = std::chrono::steady_clock::now();
-    auto duration = duration_cast<std::chrono::milliseconds>(end - start);
-    std::cout << "elapsed time: " << duration.count() << "ms\n";
+    map<string, BenchStats> results;
+
+    for (int f = firstFile; f < argc; f++) {
+        ifstream in(argv[f]);
+        int width, height;
+        in >> width >> height;
+        in.ignore();
+        Map pacMap = Map(width, height);
+        for (int i = 0; i < height; i++) {
+            string row;
+            getline(in, row);
+            pacMap.addRow(row);
+        }
+        Graph graph = pacMap.buildGraph();
+        DistanceField field = pacMap.buildDistanceField();
+        DistanceMatrix distances = DistanceMatrix(field);
+
+        //Turns in the game input format
+        vector<BenchPosition> positions;
+        int myScore, opponentScore;
+        while (in >> myScore >> opponentScore) {
+            BenchPosition position;
+            int visiblePacCount;
+            in >> visiblePacCount;
+            for (int i = 0; i < visiblePacCount; i++) {
+                int pacId, mine, x, y, speedTurnsLeft, abilityCooldown;
+                string typeId;
+                in >> pacId >> mine >> x >> y >> typeId >> speedTurnsLeft >> abilityCooldown;
+                (mine ? position.pacs : position.enemy).emplace_back(x, y);
+            }
+            int visiblePelletCount;
+            in >> visiblePelletCount;
+            for (int i = 0; i < visiblePelletCount; i++) {
+                int x, y, value;
+                in >> x >> y >> value;
+                position.pellets.emplace_back(make_pair(x, y), value);
+            }
+            positions.push_back(position);
+        }
+
+        for (int nbPacs: pacCounts) {
+            //Each repeat replays the game with new planners, like a separate match: the enemy field and
+            //the transposition table only carry over between the turns of one replay
+            for (int r = 0; r < repeats; r++) {
+                FirstPelletSimulation first = FirstPelletSimulation(field);
+                vector<unique_ptr<Simulation>> searches;
+                vector<unique_ptr<MctsSimulation>> mctses;
+                for (int depth: depths) {
+                    searches.emplace_back(new Simulation(&graph, depth, threads));
+                    searches.back()->setDistances(&distances);
+                    mctses.emplace_back(new MctsSimulation(&graph, depth));
+                }
+
+                for (auto &position: positions) {
+                    if (nbPacs > (int) position.pacs.size()) {
+                        continue;
+                    }
+                    vector<int> pellets(graph.getSize(), 0);
+                    for (auto &pellet: position.pellets) {
+                        pellets[pacMap.getIndex(pellet.first)] = pellet.second;
+                    }
+                    vector<pair<int, int>> pacs(position.pacs.begin(), position.pacs.begin() + nbPacs);
+                    vector<int> pacIndex;
+                    vector<int> enemyIndex;
+                    pacMap.toIndex(pacs, pacIndex);
+                    pacMap.toIndex(position.enemy, enemyIndex);
+                    string count = " pacs=" + to_string(nbPacs);
+
+                    //First pellet has no horizon, its quality is measured over the deepest one
+                    benchRun(results["first-pellet" + count], distances, graph, pacIndex, pellets, depths[2],
+                             [&](double &, double &) {
+                                 return first.run(pacIndex, enemyIndex, pellets.data());
+                             });
+
+                    for (int d = 0; d < (int) searches.size(); d++) {
+                        int depth = depths[d];
+                        Simulation &search = *searches[d];
+                        MctsSimulation &mcts = *mctses[d];
+                        string suffix = " d=" + to_string(depth) + count;
+
+                        benchRun(results["search" + suffix], distances, graph, pacIndex, pellets, depth,
+                                 [&](double &work, double &reached) {
+                                     vector<int> targets = search.run(pacIndex, enemyIndex, pellets.data(),
+                                                                      milliseconds(SIM_BUDGET_MS));
+                                     work = search.getNodes();
+                                     reached = search.getCompletedDepth();
+                                     return targets;
+                                 });
+                        benchRun(results["mcts" + suffix], distances, graph, pacIndex, pellets, depth,
+                                 [&](double &work, double &) {
+                                     vector<int> targets = mcts.run(pacIndex, enemyIndex, pellets.data(),
+                                                                    milliseconds(SIM_BUDGET_MS));
+                                     work = mcts.getIterations();
+                                     return targets;
+                                 });
+                    }
+                }
+            }
+        }
+    }
 
+    cout << "planner\truns\tp50 ms\tp90 ms\tp99 ms\twork/s\tdepth\tquality" << endl;
+    for (auto &entry: results) {
+        BenchStats &stats = entry.second;
+        int runs = stats.millis.size();
+        double totalMillis = accumulate(stats.millis.begin(), stats.millis.end(), 0.0);
+        cout << entry.first << "\t" << runs << "\t" << stats.percentile(0.5) << "\t" << stats.percentile(0.9)
+             << "\t" << stats.percentile(0.99) << "\t" << (long) (stats.work * 1000 / max(totalMillis, 1e-3))
+             << "\t" << stats.depth / runs << "\t" << stats.quality / runs << endl;
+    }
+}
 
-}
\ No newline at end of file
+#endif
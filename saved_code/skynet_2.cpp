@@ -2,68 +2,280 @@
 #include <string>
 #include <vector>
 #include <algorithm>
-#include <list>
 
 using namespace std;
 
+//Non-owning view over the live links of one node
+class Neighbors {
+    const int *first;
+    const int *last;
+
+public:
+    Neighbors(const int *first, const int *last) : first(first), last(last) {}
+
+    const int *begin() const {
+        return first;
+    }
+
+    const int *end() const {
+        return last;
+    }
+
+    bool empty() const {
+        return first == last;
+    }
+
+    int front() const {
+        return *first;
+    }
+};
+
+//Flat adjacency: the links of node v are neighbors[offsets[v], offsets[v] + degree[v]), a cut link is swapped
+//behind the live ones
 class Graph {
-    list<int> *adj;
     int size;
+    vector<int> offsets;
+    vector<int> neighbors;
+    vector<int> degree;
 
 public:
 
-    explicit Graph(int size) : size(size) {
-        adj = new list<int>[size];
+    Graph(int size, const vector<pair<int, int>> &links) : size(size), offsets(size + 1, 0), degree(size, 0) {
+        for (auto &link: links) {
+            degree[link.first]++;
+            degree[link.second]++;
+        }
+        for (int v = 0; v < size; v++) {
+            offsets[v + 1] = offsets[v] + degree[v];
+            degree[v] = 0;
+        }
+        neighbors.resize(offsets[size]);
+        for (auto &link: links) {
+            neighbors[offsets[link.first] + degree[link.first]++] = link.second;
+            neighbors[offsets[link.second] + degree[link.second]++] = link.first;
+        }
     }
 
-    void addEdge(int u, int v) {
-        adj[u].push_back(v);
-    }
     void removeEdge(int u, int v){
-        adj[u].remove(v);
+        int *first = neighbors.data() + offsets[u];
+        int *last = first + degree[u];
+        int *link = find(first, last, v);
+        if (link != last) {
+            swap(*link, *(last - 1));
+            degree[u]--;
+        }
     }
 
-    const list<int> getAdj(int index) const {
-        return adj[index];
+    Neighbors getAdj(int index) const {
+        const int *first = neighbors.data() + offsets[index];
+        return Neighbors(first, first + degree[index]);
     }
 
     int getSize() const {
         return size;
     }
 
-    bool shortest_path(int src, int dest,int* pred,int* dist){
-        bool * visited = new bool[size];
-        for (int i =0 ; i < size;i++){
-            visited[i] = false;
+    //Both directions of every link
+    int getArcCount() const {
+        return offsets[size];
+    }
+
+    //One BFS seeded from every gateway: distance of each node to its nearest gateway, size when none is reachable,
+    //and number of links each node has to a gateway
+    void bfsFromGateways(const vector<int> &gateways, vector<int> &dist, vector<int> &links) const {
+        dist.assign(size, size);
+        links.assign(size, 0);
+        vector<int> queue;
+        queue.reserve(size);
+        for (auto g: gateways) {
+            dist[g] = 0;
+            queue.push_back(g);
         }
+        for (size_t head = 0; head < queue.size(); head++) {
+            int s = queue[head];
+            for (auto i: getAdj(s)) {
+                if (dist[s] == 0) {
+                    links[i]++;
+                }
+                if (dist[i] == size) {
+                    dist[i] = dist[s] + 1;
+                    queue.push_back(i);
+                }
+            }
+        }
+    }
 
-        list<int> queue;
+};
 
-        queue.push_back(src);
-        visited[src] = true;
-        dist[src] = 0;
+//Distance from every node to its nearest gateway, kept up to date as links are cut (decremental BFS, Even-Shiloach).
+//Labels only grow: a node whose last neighbor one step closer is cut moves one level up and its own children
+//are rechecked, so a cut costs the nodes whose distance actually changes.
+class GatewayDistances {
+    Graph &graph;
+    int unreachable;
+    vector<int> dist;
+    vector<int> links;
+    //Neighbors one step closer to a gateway
+    vector<int> support;
+    vector<bool> gateway;
+    vector<int> pending;
 
-        while(queue.size() >0){
-            int s = queue.front();
-            queue.pop_front();
+    int countSupport(int v) const {
+        int count = 0;
+        for (auto n: graph.getAdj(v)) {
+            if (dist[n] == dist[v] - 1) {
+                count++;
+            }
+        }
+        return count;
+    }
 
-            for (auto i: adj[s]){
-                if(!visited[i]){
-                    visited[i] = true;
-                    dist[i] = dist[s] + 1;
-                    pred[i] = s;
-                    queue.push_back(i);
-                    if (i == dest){
-                        return true;
-                    }
+    void loseSupport(int v) {
+        if (!gateway[v] && dist[v] < unreachable && --support[v] == 0) {
+            pending.push_back(v);
+        }
+    }
+
+public:
+    GatewayDistances(Graph &graph, const vector<int> &gateways) : graph(graph), unreachable(graph.getSize()),
+                                                                   support(graph.getSize(), 0),
+                                                                   gateway(graph.getSize(), false) {
+        for (auto g: gateways) {
+            gateway[g] = true;
+        }
+        graph.bfsFromGateways(gateways, dist, links);
+        for (int v = 0; v < graph.getSize(); v++) {
+            support[v] = countSupport(v);
+        }
+    }
+
+    //Removes the link and repairs the labels
+    void cut(int u, int v) {
+        graph.removeEdge(u, v);
+        graph.removeEdge(v, u);
+        if (gateway[u]) {
+            links[v]--;
+        }
+        if (gateway[v]) {
+            links[u]--;
+        }
+        if (dist[u] == dist[v] + 1) {
+            loseSupport(u);
+        } else if (dist[v] == dist[u] + 1) {
+            loseSupport(v);
+        }
+
+        while (!pending.empty()) {
+            int x = pending.back();
+            pending.pop_back();
+            if (support[x] > 0) {
+                continue;
+            }
+            //Moving up, x stops supporting the neighbors one level below and supports those two levels below
+            for (auto n: graph.getAdj(x)) {
+                if (dist[n] == dist[x] + 1) {
+                    loseSupport(n);
+                } else if (dist[n] == dist[x] + 2 && dist[x] + 1 < unreachable) {
+                    support[n]++;
                 }
             }
+            dist[x]++;
+            if (dist[x] >= unreachable) {
+                dist[x] = unreachable;
+                continue;
+            }
+            support[x] = countSupport(x);
+            if (support[x] == 0) {
+                pending.push_back(x);
+            }
+        }
+    }
+
+    int getDist(int v) const {
+        return dist[v];
+    }
+
+    //Links from v to a gateway
+    int getLinks(int v) const {
+        return links[v];
+    }
+
+    bool isReachable(int v) const {
+        return dist[v] < unreachable;
+    }
+
+    //Neighbor of v one step closer to a gateway
+    int nextStep(int v) const {
+        for (auto n: graph.getAdj(v)) {
+            if (dist[n] == dist[v] - 1) {
+                return n;
+            }
+        }
+        return -1;
+    }
+};
 
+//Picks the most urgent node touching several gateways. The agent walks through gateway-linked nodes without
+//giving us a spare cut (each one forces its own cut), so a 0-1 BFS from the agent counts only the steps onto
+//unlinked nodes. A node with k gateway links needs k - 1 spare cuts before the agent gets there: the one with
+//the smallest slack, spare cuts minus links, is cut first.
+class CutPlanner {
+    const Graph &graph;
+    const GatewayDistances &distances;
+    vector<bool> gateway;
+    vector<int> cost;
+    //Double ended queue over a flat buffer, every arc pushes at most once per turn
+    vector<int> queue;
+
+public:
+    CutPlanner(const Graph &graph, const GatewayDistances &distances, const vector<int> &gateways) :
+            graph(graph), distances(distances), gateway(graph.getSize(), false), cost(graph.getSize()),
+            queue(2 * (graph.getArcCount() + 1)) {
+        for (auto g: gateways) {
+            gateway[g] = true;
         }
-        return false;
     }
 
+    //Node with two or more gateway links to cut from, -1 when there is none the agent can reach
+    int plan(int agent) {
+        int unreached = graph.getSize() + 1;
+        fill(cost.begin(), cost.end(), unreached);
+        int head = graph.getArcCount() + 1;
+        int tail = head;
+        cost[agent] = 0;
+        queue[tail++] = agent;
+        while (head < tail) {
+            int s = queue[head++];
+            for (auto i: graph.getAdj(s)) {
+                if (gateway[i]) {
+                    continue;
+                }
+                int step = distances.getLinks(i) > 0 ? 0 : 1;
+                if (cost[s] + step < cost[i]) {
+                    cost[i] = cost[s] + step;
+                    if (step == 0) {
+                        queue[--head] = i;
+                    } else {
+                        queue[tail++] = i;
+                    }
+                }
+            }
+        }
 
+        int best = -1;
+        int bestSlack = 0;
+        for (int v = 0; v < graph.getSize(); v++) {
+            if (cost[v] == unreached || distances.getLinks(v) < 2) {
+                continue;
+            }
+            int slack = cost[v] - distances.getLinks(v);
+            if (best < 0 || slack < bestSlack || (slack == bestSlack && cost[v] < cost[best])) {
+                best = v;
+                bestSlack = slack;
+            }
+        }
+        return best;
+    }
 };
 
 int main()
@@ -74,7 +286,7 @@ int main()
     cin >> N >> L >> E; cin.ignore();
     cerr << N << " " <<L <<" "<<E  << endl;
 
-    Graph graph = Graph(N);
+    vector<pair<int, int>> links;
     vector<int> gateways;
 
     for (int i = 0; i < L; i++) {
@@ -82,8 +294,7 @@ int main()
         int N2;
         cin >> N1 >> N2; cin.ignore();
         cerr << N1 << " " << N2 << endl;
-        graph.addEdge(N1, N2);
-        graph.addEdge(N2, N1);
+        links.emplace_back(N1, N2);
     }
     for (int i = 0; i < E; i++) {
         int EI; // the index of a gateway node
@@ -92,28 +303,35 @@ int main()
         gateways.push_back(EI);
     }
 
+    Graph graph = Graph(N, links);
+    GatewayDistances distances = GatewayDistances(graph, gateways);
+    CutPlanner planner = CutPlanner(graph, distances, gateways);
+
     // game loop
     while (1) {
         int SI; // The index of the node on which the Skynet agent is positioned this turn
         cin >> SI; cin.ignore();
         cerr << SI <<endl;
-        int min_dist = INT32_MAX;
-        int min_pred = 0;
-        int min_gateway = 0;
-
-        for (auto gateway : gateways){
-            int * pred = new int[N];
-            int * dist = new int[N];
-            if (graph.shortest_path(SI, gateway, pred, dist)){
-                if(dist[gateway] < min_dist){
-                    min_dist = dist[gateway];
-                    min_pred = pred[gateway];
-                    min_gateway = gateway;
-                }
+        //An exit next to the agent is cut first, then the most urgent multi-gateway node, otherwise follow the
+        //agent's shortest path to its nearest gateway and cut the last link
+        int node = distances.getLinks(SI) > 0 ? SI : planner.plan(SI);
+        if (node < 0) {
+            node = SI;
+        }
+        if (node == SI && distances.isReachable(SI)) {
+            while (distances.getDist(node) > 1) {
+                node = distances.nextStep(node);
+            }
+        }
+        int gateway = distances.nextStep(node);
+        //The agent is cut off already, any gateway link left will do
+        for (auto g = gateways.begin(); gateway < 0 && g != gateways.end(); g++) {
+            if (!graph.getAdj(*g).empty()) {
+                node = graph.getAdj(*g).front();
+                gateway = *g;
             }
         }
-        graph.removeEdge(min_pred,min_gateway);
-        graph.removeEdge(min_gateway,min_pred);
-        cout << min_pred << " " <<min_gateway << endl;
+        distances.cut(node, gateway);
+        cout << node << " " << gateway << endl;
     }
 }
\ No newline at end of file